@@ -0,0 +1,254 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <vector>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+using namespace std;
+
+// Bump allocator for short-lived matrices. Allocating moves a cursor through a chunk; freeing is a
+// no-op except for the most recent allocation, which is rolled back. reset() frees everything in one
+// step and keeps the memory, so a loop that resets after each request stops allocating once warm;
+// mark() and rewind() do the same for just the allocations made after a point.
+// One arena belongs to one thread at a time (see ArenaScope); it is not safe for concurrent use.
+class MatrixArena {
+public:
+    // A point to rewind() to
+    struct Mark {
+        size_t chunk;
+        char* cursor;
+        size_t used;
+        size_t allocations;
+    };
+
+    explicit MatrixArena(size_t chunkBytes = 64 * 1024)
+        : nextChunk(max<size_t>(chunkBytes, chunkAlign)), current(0), cursor(nullptr), limit(nullptr),
+          last(nullptr), bytesUsed(0), allocations(0) {}
+
+    ~MatrixArena() { freeChunks(); }
+
+    MatrixArena(const MatrixArena&) = delete;
+    MatrixArena& operator=(const MatrixArena&) = delete;
+
+    void* allocate(size_t bytes, size_t align) {
+        char* p = alignUp(cursor, align);
+        if (cursor == nullptr || p > limit || bytes > static_cast<size_t>(limit - p)) {
+            if (bytes > numeric_limits<size_t>::max() / 2 - align) throw bad_alloc();
+            // Chunks left behind by a rewind are reused before a new one is added
+            size_t next = cursor == nullptr ? 0 : current + 1;
+            while (next < chunks.size() && chunks[next].size < bytes + align) next++;
+            if (next == chunks.size()) {
+                chunks.push_back({static_cast<char*>(::operator new(max(nextChunk, bytes + align), align_val_t(chunkAlign))),
+                                  max(nextChunk, bytes + align)});
+                nextChunk = chunks.back().size * 2;
+            }
+            enter(next);
+            p = alignUp(cursor, align);
+        }
+        live.push_back({allocations, p});
+        allocations++;
+        bytesUsed += (p - cursor) + bytes;
+        cursor = p + bytes;
+        last = p;
+        return p;
+    }
+
+    void deallocate(void* p, size_t bytes) noexcept {
+        // Usually the newest allocation, so the search from the back ends at once
+        for (size_t k = live.size(); k-- > 0;) {
+            if (live[k].p == p) {
+                live.erase(live.begin() + static_cast<ptrdiff_t>(k));
+                break;
+            }
+        }
+        // Undoing the latest allocation lets a temporary created and destroyed in turn reuse its bytes
+        if (p == last && static_cast<char*>(p) + bytes == cursor) {
+            bytesUsed -= bytes;
+            cursor = last;
+            last = nullptr;
+        }
+    }
+
+    Mark mark() const { return {current, cursor, bytesUsed, allocations}; }
+
+    // Frees everything allocated after m at once; throws if any of it is still in use. Allocations
+    // from before m may stay alive, and freeing them does not make up for one after m.
+    void rewind(const Mark& m) {
+        if (!live.empty() && live.back().serial >= m.allocations) {
+            throw runtime_error("MatrixArena::rewind: matrices allocated after the mark are still alive.");
+        }
+        current = m.chunk;
+        cursor = m.cursor;
+        limit = cursor == nullptr ? nullptr : chunks[current].base + chunks[current].size;
+        last = nullptr;
+        bytesUsed = m.used;
+    }
+
+    // Frees every allocation at once. Memory spread over several chunks is merged into one chunk of
+    // the same total size, so the next round fits in one piece.
+    void reset() {
+        checkUnused("reset");
+        if (chunks.size() > 1) {
+            const size_t total = capacity();
+            freeChunks();
+            chunks.push_back({static_cast<char*>(::operator new(total, align_val_t(chunkAlign))), total});
+        }
+        if (!chunks.empty()) enter(0);
+        last = nullptr;
+        bytesUsed = 0;
+    }
+
+    // Like reset(), but also returns the memory to the heap
+    void release() {
+        checkUnused("release");
+        freeChunks();
+        last = nullptr;
+        bytesUsed = 0;
+    }
+
+    // Bytes handed out since the last reset or rewind (alignment padding included), and bytes held in chunks
+    size_t used() const { return bytesUsed; }
+    size_t capacity() const {
+        size_t total = 0;
+        for (const Chunk& c : chunks) total += c.size;
+        return total;
+    }
+
+private:
+    struct Chunk {
+        char* base;
+        size_t size;
+    };
+
+    // A live allocation and how many allocations came before it
+    struct Allocation {
+        size_t serial;
+        void* p;
+    };
+
+    // Chunks are cache-line aligned, which also suits the SIMD loads in the kernels
+    static constexpr size_t chunkAlign = 64;
+
+    vector<Chunk> chunks;
+    size_t nextChunk;
+    size_t current;
+    char* cursor;
+    char* limit;
+    char* last;
+    size_t bytesUsed;
+    size_t allocations;
+    vector<Allocation> live;   // In allocation order; its capacity stays, so a warm arena allocates nothing
+
+    static char* alignUp(char* p, size_t align) {
+        const uintptr_t u = reinterpret_cast<uintptr_t>(p);
+        return p + ((align - u % align) % align);
+    }
+
+    void enter(size_t k) {
+        current = k;
+        cursor = chunks[k].base;
+        limit = cursor + chunks[k].size;
+    }
+
+    void freeChunks() noexcept {
+        for (const Chunk& c : chunks) ::operator delete(c.base, align_val_t(chunkAlign));
+        chunks.clear();
+        current = 0;
+        cursor = limit = nullptr;
+    }
+
+    void checkUnused(const char* what) const {
+        if (!live.empty()) {
+            throw runtime_error(string("MatrixArena::") + what + ": matrices allocated from the arena are still alive.");
+        }
+    }
+};
+
+// Makes an arena the current one for this thread until the scope closes; scopes nest. Matrices created
+// (constructed or copied) on this thread meanwhile take their storage from the arena, and moving one keeps
+// it there, so results that must outlive the arena should be copied after the scope has closed.
+// A default-constructed scope switches back to the heap, e.g. to build such a result inside the scope.
+class ArenaScope {
+public:
+    explicit ArenaScope(MatrixArena& arena) : previous(current()) { current() = &arena; }
+    ArenaScope() : previous(current()) { current() = nullptr; }
+    ~ArenaScope() { current() = previous; }
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+    // The innermost open arena on this thread, or nullptr for the heap
+    static MatrixArena*& current() {
+        thread_local MatrixArena* arena = nullptr;
+        return arena;
+    }
+
+private:
+    MatrixArena* previous;
+};
+
+// Runs f() with arena as the current arena and returns its result
+template <class F>
+auto withArena(MatrixArena& arena, F&& f) -> decltype(f()) {
+    ArenaScope scope(arena);
+    return f();
+}
+
+// Matrix storage allocator: draws from the arena that was current when the container was created, or
+// from the heap when there was none. Copies pick the current arena again instead of the source's, and
+// copy assignment keeps the target's storage. Move assignment and swap take the source's buffer along
+// with its arena, so they never allocate and cannot throw.
+template <class T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = false_type;
+    using propagate_on_container_move_assignment = true_type;
+    using propagate_on_container_swap = true_type;
+
+    ArenaAllocator() noexcept : arena(ArenaScope::current()) {}
+    explicit ArenaAllocator(MatrixArena* a) noexcept : arena(a) {}
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena(other.getArena()) {}
+
+    T* allocate(size_t n) {
+        if (arena == nullptr) return std::allocator<T>().allocate(n);
+        if (n > numeric_limits<size_t>::max() / sizeof(T)) throw bad_alloc();
+        return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        if (arena == nullptr) {
+            std::allocator<T>().deallocate(p, n);
+        } else {
+            arena->deallocate(p, n * sizeof(T));
+        }
+    }
+
+    ArenaAllocator select_on_container_copy_construction() const { return ArenaAllocator(); }
+
+    MatrixArena* getArena() const { return arena; }
+
+    template <class U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.getArena(); }
+    template <class U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.getArena(); }
+
+private:
+    MatrixArena* arena;
+};
+
+// Per-thread arena for temporaries that never leave a library call (minors in getCofMatrix())
+inline MatrixArena& scratchArena() {
+    thread_local MatrixArena arena;
+    return arena;
+}
+
+#endif  // ARENA_H
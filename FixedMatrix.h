@@ -0,0 +1,498 @@
+#ifndef FIXEDMATRIX_H
+#define FIXEDMATRIX_H
+
+#include <vector>
+#include <stdexcept>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+#include <initializer_list>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include "Matrix.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define FIXED_VECTOR_EXTENSIONS 1
+#endif
+
+using namespace std;
+
+// Small matrices whose shape is part of the type: R x C elements in a plain array (no heap),
+// element-wise loops unrolled at compile time, and closed-form determinant and inverse up to 4 x 4.
+// Meant for millions of 3x3 / 4x4 transforms where BasicMatrix's allocation and generality dominate.
+template <class T, int R, int C>
+class FixedMatrix {
+    static_assert(R > 0 && C > 0, "FixedMatrix dimensions must be positive.");
+
+public:
+    using value_type = T;
+
+    constexpr FixedMatrix() : a{} {}
+
+    // FixedMatrix<double, 2, 2> m({{1, 2}, {3, 4}}); missing entries are zero
+    constexpr FixedMatrix(initializer_list<initializer_list<T>> rows) : a{} {
+        if (static_cast<int>(rows.size()) > R) {
+            throw invalid_argument("FixedMatrix: too many rows in initializer.");
+        }
+        int i = 0;
+        for (const auto& r : rows) {
+            if (static_cast<int>(r.size()) > C) {
+                throw invalid_argument("FixedMatrix: too many columns in initializer.");
+            }
+            int j = 0;
+            for (const T& v : r) a[i * C + j++] = v;
+            i++;
+        }
+    }
+
+    explicit FixedMatrix(const BasicMatrix<T>& m) : a{} {
+        if (m.getRow() != R || m.getCol() != C) {
+            throw runtime_error("Matrix dimensions do not match for conversion!");
+        }
+        for (int i = 0; i < R; i++) {
+            copy(m.data() + static_cast<size_t>(i) * m.getLd(), m.data() + static_cast<size_t>(i) * m.getLd() + C, a + i * C);
+        }
+    }
+
+    BasicMatrix<T> toMatrix() const {
+        BasicMatrix<T> m(R, C);
+        copy(a, a + R * C, m.data());
+        return m;
+    }
+
+    static constexpr FixedMatrix identity() {
+        FixedMatrix m;
+        for (int i = 0; i < min(R, C); i++) m.a[i * C + i] = 1;
+        return m;
+    }
+
+    static constexpr int getRow() { return R; }
+    static constexpr int getCol() { return C; }
+
+    constexpr T& operator()(int i, int j) { return a[i * C + j]; }
+    constexpr const T& operator()(int i, int j) const { return a[i * C + j]; }
+    constexpr T* data() { return a; }
+    constexpr const T* data() const { return a; }
+
+    constexpr FixedMatrix operator+(const FixedMatrix& o) const {
+        return zip(o, [](T x, T y) { return x + y; }, make_index_sequence<R * C>());
+    }
+    constexpr FixedMatrix operator-(const FixedMatrix& o) const {
+        return zip(o, [](T x, T y) { return x - y; }, make_index_sequence<R * C>());
+    }
+    constexpr FixedMatrix operator*(T s) const {
+        return zip(*this, [s](T x, T) { return x * s; }, make_index_sequence<R * C>());
+    }
+    constexpr FixedMatrix operator-() const {
+        return zip(*this, [](T x, T) { return -x; }, make_index_sequence<R * C>());
+    }
+
+    constexpr bool operator==(const FixedMatrix& o) const {
+        for (int k = 0; k < R * C; k++) {
+            if (a[k] != o.a[k]) return false;
+        }
+        return true;
+    }
+    constexpr bool operator!=(const FixedMatrix& o) const { return !(*this == o); }
+
+    // Matrix product; every element is a fold over K, fully unrolled
+    template <int K>
+    constexpr FixedMatrix<T, R, K> operator*(const FixedMatrix<T, C, K>& b) const {
+        FixedMatrix<T, R, K> out;
+        productElements(b, out, make_index_sequence<R * K>());
+        return out;
+    }
+
+    constexpr FixedMatrix<T, C, R> transpose() const {
+        FixedMatrix<T, C, R> t;
+        for (int i = 0; i < R; i++) {
+            for (int j = 0; j < C; j++) t(j, i) = a[i * C + j];
+        }
+        return t;
+    }
+
+    // Closed form up to 4 x 4 (no branches, so it vectorizes across a batch); pivoted elimination beyond
+    constexpr T determinant() const {
+        static_assert(R == C, "Determinant requires a square matrix.");
+        const FixedMatrix& m = *this;
+        if constexpr (R == 1) {
+            return m(0, 0);
+        } else if constexpr (R == 2) {
+            return m(0, 0) * m(1, 1) - m(0, 1) * m(1, 0);
+        } else if constexpr (R == 3) {
+            return m(0, 0) * (m(1, 1) * m(2, 2) - m(1, 2) * m(2, 1))
+                 - m(0, 1) * (m(1, 0) * m(2, 2) - m(1, 2) * m(2, 0))
+                 + m(0, 2) * (m(1, 0) * m(2, 1) - m(1, 1) * m(2, 0));
+        } else if constexpr (R == 4) {
+            const Minors4 k = minors4();
+            return k.s0 * k.c5 - k.s1 * k.c4 + k.s2 * k.c3 + k.s3 * k.c2 - k.s4 * k.c1 + k.s5 * k.c0;
+        } else {
+            FixedMatrix lu = m;
+            T d = 1;
+            for (int k = 0; k < R; k++) {
+                int p = k;
+                for (int i = k + 1; i < R; i++) {
+                    if (fabs(lu(i, k)) > fabs(lu(p, k))) p = i;
+                }
+                if (lu(p, k) == T(0)) return T(0);
+                if (p != k) {
+                    for (int j = 0; j < R; j++) swap(lu(k, j), lu(p, j));
+                    d = -d;
+                }
+                d *= lu(k, k);
+                for (int i = k + 1; i < R; i++) {
+                    const T f = lu(i, k) / lu(k, k);
+                    for (int j = k + 1; j < R; j++) lu(i, j) -= f * lu(k, j);
+                }
+            }
+            return d;
+        }
+    }
+
+    constexpr FixedMatrix inverse() const {
+        const T d = determinant();
+        if (d == T(0)) {
+            throw runtime_error("Matrix is not invertible!");
+        }
+        return inverseGivenDeterminant(d);
+    }
+
+    // Inverse when det(*this) == d is already known and non-zero: adjugate / d up to 4 x 4,
+    // Gauss-Jordan with partial pivoting beyond
+    constexpr FixedMatrix inverseGivenDeterminant(T d) const {
+        static_assert(R == C, "Inverse requires a square matrix.");
+        const FixedMatrix& m = *this;
+        const T s = T(1) / d;
+        FixedMatrix inv;
+        if constexpr (R == 1) {
+            inv(0, 0) = s;
+        } else if constexpr (R == 2) {
+            inv(0, 0) = m(1, 1) * s;
+            inv(0, 1) = -m(0, 1) * s;
+            inv(1, 0) = -m(1, 0) * s;
+            inv(1, 1) = m(0, 0) * s;
+        } else if constexpr (R == 3) {
+            inv(0, 0) = (m(1, 1) * m(2, 2) - m(1, 2) * m(2, 1)) * s;
+            inv(0, 1) = (m(0, 2) * m(2, 1) - m(0, 1) * m(2, 2)) * s;
+            inv(0, 2) = (m(0, 1) * m(1, 2) - m(0, 2) * m(1, 1)) * s;
+            inv(1, 0) = (m(1, 2) * m(2, 0) - m(1, 0) * m(2, 2)) * s;
+            inv(1, 1) = (m(0, 0) * m(2, 2) - m(0, 2) * m(2, 0)) * s;
+            inv(1, 2) = (m(0, 2) * m(1, 0) - m(0, 0) * m(1, 2)) * s;
+            inv(2, 0) = (m(1, 0) * m(2, 1) - m(1, 1) * m(2, 0)) * s;
+            inv(2, 1) = (m(0, 1) * m(2, 0) - m(0, 0) * m(2, 1)) * s;
+            inv(2, 2) = (m(0, 0) * m(1, 1) - m(0, 1) * m(1, 0)) * s;
+        } else if constexpr (R == 4) {
+            // Laplace expansion by complementary 2x2 minors of the top and bottom row pairs
+            const Minors4 k = minors4();
+            inv(0, 0) = ( m(1, 1) * k.c5 - m(1, 2) * k.c4 + m(1, 3) * k.c3) * s;
+            inv(0, 1) = (-m(0, 1) * k.c5 + m(0, 2) * k.c4 - m(0, 3) * k.c3) * s;
+            inv(0, 2) = ( m(3, 1) * k.s5 - m(3, 2) * k.s4 + m(3, 3) * k.s3) * s;
+            inv(0, 3) = (-m(2, 1) * k.s5 + m(2, 2) * k.s4 - m(2, 3) * k.s3) * s;
+            inv(1, 0) = (-m(1, 0) * k.c5 + m(1, 2) * k.c2 - m(1, 3) * k.c1) * s;
+            inv(1, 1) = ( m(0, 0) * k.c5 - m(0, 2) * k.c2 + m(0, 3) * k.c1) * s;
+            inv(1, 2) = (-m(3, 0) * k.s5 + m(3, 2) * k.s2 - m(3, 3) * k.s1) * s;
+            inv(1, 3) = ( m(2, 0) * k.s5 - m(2, 2) * k.s2 + m(2, 3) * k.s1) * s;
+            inv(2, 0) = ( m(1, 0) * k.c4 - m(1, 1) * k.c2 + m(1, 3) * k.c0) * s;
+            inv(2, 1) = (-m(0, 0) * k.c4 + m(0, 1) * k.c2 - m(0, 3) * k.c0) * s;
+            inv(2, 2) = ( m(3, 0) * k.s4 - m(3, 1) * k.s2 + m(3, 3) * k.s0) * s;
+            inv(2, 3) = (-m(2, 0) * k.s4 + m(2, 1) * k.s2 - m(2, 3) * k.s0) * s;
+            inv(3, 0) = (-m(1, 0) * k.c3 + m(1, 1) * k.c1 - m(1, 2) * k.c0) * s;
+            inv(3, 1) = ( m(0, 0) * k.c3 - m(0, 1) * k.c1 + m(0, 2) * k.c0) * s;
+            inv(3, 2) = (-m(3, 0) * k.s3 + m(3, 1) * k.s1 - m(3, 2) * k.s0) * s;
+            inv(3, 3) = ( m(2, 0) * k.s3 - m(2, 1) * k.s1 + m(2, 2) * k.s0) * s;
+        } else {
+            FixedMatrix work = m;
+            inv = identity();
+            for (int k = 0; k < R; k++) {
+                int p = k;
+                for (int i = k + 1; i < R; i++) {
+                    if (fabs(work(i, k)) > fabs(work(p, k))) p = i;
+                }
+                for (int j = 0; j < R; j++) {
+                    swap(work(k, j), work(p, j));
+                    swap(inv(k, j), inv(p, j));
+                }
+                const T pivot = T(1) / work(k, k);
+                for (int j = 0; j < R; j++) {
+                    work(k, j) *= pivot;
+                    inv(k, j) *= pivot;
+                }
+                for (int i = 0; i < R; i++) {
+                    if (i == k) continue;
+                    const T f = work(i, k);
+                    for (int j = 0; j < R; j++) {
+                        work(i, j) -= f * work(k, j);
+                        inv(i, j) -= f * inv(k, j);
+                    }
+                }
+            }
+        }
+        return inv;
+    }
+
+private:
+    T a[R * C];
+
+    template <class F, size_t... K>
+    constexpr FixedMatrix zip(const FixedMatrix& o, F f, index_sequence<K...>) const {
+        FixedMatrix out;
+        ((out.a[K] = f(a[K], o.a[K])), ...);
+        return out;
+    }
+
+    template <int K, size_t... P>
+    constexpr T productElement(const FixedMatrix<T, C, K>& b, int i, int j, index_sequence<P...>) const {
+        return ((a[i * C + P] * b(static_cast<int>(P), j)) + ...);
+    }
+
+    template <int K, size_t... E>
+    constexpr void productElements(const FixedMatrix<T, C, K>& b, FixedMatrix<T, R, K>& out, index_sequence<E...>) const {
+        ((out(static_cast<int>(E) / K, static_cast<int>(E) % K) =
+              productElement(b, static_cast<int>(E) / K, static_cast<int>(E) % K, make_index_sequence<C>())), ...);
+    }
+
+    // 2x2 minors of rows (0, 1) (s) and rows (2, 3) (c) over the column pairs 01 02 03 12 13 23
+    struct Minors4 { T s0, s1, s2, s3, s4, s5, c0, c1, c2, c3, c4, c5; };
+
+    constexpr Minors4 minors4() const {
+        const FixedMatrix& m = *this;
+        return Minors4{
+            m(0, 0) * m(1, 1) - m(1, 0) * m(0, 1), m(0, 0) * m(1, 2) - m(1, 0) * m(0, 2),
+            m(0, 0) * m(1, 3) - m(1, 0) * m(0, 3), m(0, 1) * m(1, 2) - m(1, 1) * m(0, 2),
+            m(0, 1) * m(1, 3) - m(1, 1) * m(0, 3), m(0, 2) * m(1, 3) - m(1, 2) * m(0, 3),
+            m(2, 0) * m(3, 1) - m(3, 0) * m(2, 1), m(2, 0) * m(3, 2) - m(3, 0) * m(2, 2),
+            m(2, 0) * m(3, 3) - m(3, 0) * m(2, 3), m(2, 1) * m(3, 2) - m(3, 1) * m(2, 2),
+            m(2, 1) * m(3, 3) - m(3, 1) * m(2, 3), m(2, 2) * m(3, 3) - m(3, 2) * m(2, 3)};
+    }
+};
+
+template <class T, int R, int C>
+constexpr FixedMatrix<T, R, C> operator*(T s, const FixedMatrix<T, R, C>& m) {
+    return m * s;
+}
+
+using Matrix2 = FixedMatrix<double, 2, 2>;
+using Matrix3 = FixedMatrix<double, 3, 3>;
+using Matrix4 = FixedMatrix<double, 4, 4>;
+using Matrix3F = FixedMatrix<float, 3, 3>;
+using Matrix4F = FixedMatrix<float, 4, 4>;
+
+namespace fixed_detail {
+
+// Bytes in one SIMD register of the compilation target
+#if defined(__AVX512F__)
+constexpr size_t laneBytes = 64;
+#elif defined(__AVX__)
+constexpr size_t laneBytes = 32;
+#else
+constexpr size_t laneBytes = 16;
+#endif
+
+// One SIMD register's worth of T. The FixedMatrix formulas are written against + - * /,
+// so FixedMatrix<Lanes<T>, R, C> evaluates them for `width` matrices at once.
+#ifdef FIXED_VECTOR_EXTENSIONS
+template <class T>
+struct Lanes {
+    typedef T V __attribute__((vector_size(laneBytes)));
+    static constexpr int width = laneBytes / sizeof(T);
+    V v;
+
+    Lanes() : v{} {}
+    Lanes(T s) : v(V{} + s) {}
+
+    static Lanes load(const T* p) {
+        Lanes r;
+        memcpy(&r.v, p, sizeof(V));
+        return r;
+    }
+    void store(T* p) const { memcpy(p, &v, sizeof(V)); }
+
+    friend Lanes operator+(Lanes a, Lanes b) { a.v += b.v; return a; }
+    friend Lanes operator-(Lanes a, Lanes b) { a.v -= b.v; return a; }
+    friend Lanes operator*(Lanes a, Lanes b) { a.v *= b.v; return a; }
+    friend Lanes operator/(Lanes a, Lanes b) { a.v /= b.v; return a; }
+    Lanes operator-() const { Lanes r; r.v = -v; return r; }
+};
+#else
+// Without GCC/Clang vector extensions: a plain array whose fixed-length loops the optimizer may vectorize
+template <class T>
+struct Lanes {
+    static constexpr int width = laneBytes / sizeof(T);
+    T v[width];
+
+    Lanes() : v{} {}
+    Lanes(T s) { for (int i = 0; i < width; i++) v[i] = s; }
+
+    static Lanes load(const T* p) {
+        Lanes r;
+        memcpy(r.v, p, sizeof(r.v));
+        return r;
+    }
+    void store(T* p) const { memcpy(p, v, sizeof(v)); }
+
+    friend Lanes operator+(Lanes a, Lanes b) { for (int i = 0; i < width; i++) a.v[i] += b.v[i]; return a; }
+    friend Lanes operator-(Lanes a, Lanes b) { for (int i = 0; i < width; i++) a.v[i] -= b.v[i]; return a; }
+    friend Lanes operator*(Lanes a, Lanes b) { for (int i = 0; i < width; i++) a.v[i] *= b.v[i]; return a; }
+    friend Lanes operator/(Lanes a, Lanes b) { for (int i = 0; i < width; i++) a.v[i] /= b.v[i]; return a; }
+    Lanes operator-() const { Lanes r; for (int i = 0; i < width; i++) r.v[i] = -v[i]; return r; }
+};
+#endif
+
+// Names the value type a batch kernel runs on without passing a (wide) value of it
+template <class V>
+struct Tag { using type = V; };
+
+// Lane packs are used for float and double only; other element types run one matrix at a time
+template <class T>
+constexpr bool hasLanes = is_same<T, float>::value || is_same<T, double>::value;
+
+}  // namespace fixed_detail
+
+// N matrices of the same small shape stored structure-of-arrays: element (i, j) of every matrix
+// is one contiguous run of N values, so element (i, j) of `width` consecutive matrices is one SIMD
+// load. Batch operations run the FixedMatrix formulas on those lane packs (closed forms up to 4 x 4),
+// the leftover tail one matrix at a time, and split large batches across the thread pool.
+template <class T, int R, int C>
+class FixedMatrixBatch {
+public:
+    using Element = FixedMatrix<T, R, C>;
+
+    FixedMatrixBatch() : n(0) {}
+    explicit FixedMatrixBatch(size_t count) : n(count), v(count * R * C, T(0)) {}
+
+    size_t size() const { return n; }
+
+    // Contiguous values of element (i, j) across the batch
+    T* lane(int i, int j) { return v.data() + static_cast<size_t>(i * C + j) * n; }
+    const T* lane(int i, int j) const { return v.data() + static_cast<size_t>(i * C + j) * n; }
+
+    Element get(size_t b) const { return load<T>(b); }
+
+    void set(size_t b, const Element& m) { store(b, m); }
+
+    // Matrices [q, q + width) as one FixedMatrix of lane packs (V = fixed_detail::Lanes<T>),
+    // or matrix q alone (V = T); the building blocks of the batch kernels below
+    template <class V>
+    FixedMatrix<V, R, C> load(size_t q) const {
+        FixedMatrix<V, R, C> m;
+        for (int k = 0; k < R * C; k++) m.data()[k] = loadValue<V>(v.data() + k * n + q);
+        return m;
+    }
+
+    template <class V>
+    void store(size_t q, const FixedMatrix<V, R, C>& m) {
+        for (int k = 0; k < R * C; k++) storeValue(v.data() + k * n + q, m.data()[k]);
+    }
+
+    // out[b] = a[b] * b[b] for every b
+    template <int K>
+    friend FixedMatrixBatch<T, R, K> operator*(const FixedMatrixBatch& a, const FixedMatrixBatch<T, C, K>& b) {
+        if (a.size() != b.size()) {
+            throw runtime_error("Batch sizes do not match!");
+        }
+        FixedMatrixBatch<T, R, K> out(a.size());
+        forEachPack(a.size(), R * C * K, [&](auto tag, size_t q) {
+            using V = typename decltype(tag)::type;
+            out.store(q, a.template load<V>(q) * b.template load<V>(q));
+        });
+        return out;
+    }
+
+    // out[b] = m * x[b]: one matrix (e.g. a transform) applied to every member of the batch
+    template <int K>
+    friend FixedMatrixBatch<T, K, C> operator*(const FixedMatrix<T, K, R>& m, const FixedMatrixBatch& x) {
+        FixedMatrixBatch<T, K, C> out(x.size());
+        forEachPack(x.size(), K * R * C, [&](auto tag, size_t q) {
+            using V = typename decltype(tag)::type;
+            FixedMatrix<V, K, R> mv;
+            for (int k = 0; k < K * R; k++) mv.data()[k] = V(m.data()[k]);
+            out.store(q, mv * x.template load<V>(q));
+        });
+        return out;
+    }
+
+    vector<T> determinants() const {
+        vector<T> d(n);
+        forEachPack(n, R * C * R, [&](auto tag, size_t q) {
+            using V = typename decltype(tag)::type;
+            storeValue(d.data() + q, load<V>(q).determinant());
+        });
+        return d;
+    }
+
+    // Every member inverted; throws if any of them is singular (see tryInverse)
+    FixedMatrixBatch inverse() const {
+        vector<char> singular;
+        FixedMatrixBatch out = tryInverse(singular);
+        if (find(singular.begin(), singular.end(), 1) != singular.end()) {
+            throw runtime_error("Matrix is not invertible!");
+        }
+        return out;
+    }
+
+    // Inverts every member; singular ones are left zero and flagged in singular[b]
+    FixedMatrixBatch tryInverse(vector<char>& singular) const {
+        FixedMatrixBatch out(n);
+        singular.assign(n, 0);
+        forEachPack(n, 4 * R * C * R, [&](auto tag, size_t q) {
+            using V = typename decltype(tag)::type;
+            constexpr int w = width<V>();
+            const FixedMatrix<V, R, C> m = load<V>(q);
+            // Singular members divide by 1 instead of 0 and are cleared afterwards
+            T d[w];
+            storeValue(d, m.determinant());
+            bool any = false;
+            for (int l = 0; l < w; l++) {
+                if (d[l] == T(0)) {
+                    singular[q + l] = 1;
+                    d[l] = 1;
+                    any = true;
+                }
+            }
+            out.store(q, m.inverseGivenDeterminant(loadValue<V>(d)));
+            if (any) {
+                for (int l = 0; l < w; l++) {
+                    if (singular[q + l]) out.store(q + l, Element());
+                }
+            }
+        });
+        return out;
+    }
+
+private:
+    size_t n;
+    vector<T> v;  // v[(i * C + j) * n + b] is element (i, j) of matrix b
+
+    using Pack = fixed_detail::Lanes<T>;
+
+    template <class V>
+    static constexpr int width() {
+        if constexpr (is_same<V, T>::value) return 1; else return V::width;
+    }
+
+    template <class V>
+    static V loadValue(const T* p) {
+        if constexpr (is_same<V, T>::value) return *p; else return V::load(p);
+    }
+
+    template <class V>
+    static void storeValue(T* p, const V& x) {
+        if constexpr (is_same<V, T>::value) *p = x; else x.store(p);
+    }
+
+    // Calls body(Tag<Pack>, q) for whole lane packs and body(Tag<T>, q) for the rest. The closed forms
+    // are branch-free up to 4 x 4; larger matrices pivot per matrix, so they always run one at a time.
+    template <class F>
+    static void forEachPack(size_t count, size_t workPerItem, F&& body) {
+        parallelFor(0, count, workPerItem, [&](size_t lo, size_t hi) {
+            size_t q = lo;
+            if constexpr (fixed_detail::hasLanes<T> && R <= 4 && C <= 4) {
+                for (; q + Pack::width <= hi; q += Pack::width) body(fixed_detail::Tag<Pack>(), q);
+            }
+            for (; q < hi; q++) body(fixed_detail::Tag<T>(), q);
+        });
+    }
+};
+
+#endif  // FIXEDMATRIX_H
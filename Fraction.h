@@ -0,0 +1,96 @@
+#ifndef FRACTION_H
+#define FRACTION_H
+
+#include <string>
+#include <cmath>
+#include <cstdio>
+#include <charconv>
+
+using namespace std;
+
+// Rational approximation for printing: the fraction p/q (q <= maxDenominator) with the smallest q that
+// is within 1e-6 of value, or, if there is none, the closest such fraction (smallest q on ties).
+// Only convergents and semiconvergents of value's continued fraction can be records for "closest with
+// denominator at most q", so instead of trying every denominator this walks the continued fraction,
+// one run of semiconvergents at a time. Within a run the distance to value shrinks monotonically,
+// which lets the first fraction within the tolerance be found by bisection.
+inline void bestFraction(double value, long long maxDenominator, long long& num, long long& den) {
+    const double tolerance = 1e-6;
+    num = 0;
+    den = 1;
+    double bestError = fabs(value);
+    // Candidate q with its closest numerator; true once the tolerance is met
+    auto consider = [&](long long q) {
+        const long long p = static_cast<long long>(round(value * q));
+        const double error = fabs(value - static_cast<double>(p) / q);
+        if (error < bestError) {
+            bestError = error;
+            num = p;
+            den = q;
+        }
+        return bestError < tolerance;
+    };
+    if (maxDenominator < 1 || consider(1)) return;
+
+    // Convergents h/k: (h2, k2) = (h[n-2], k[n-2]) and (h1, k1) = (h[n-1], k[n-1])
+    double x = value;
+    long long a = static_cast<long long>(floor(x));
+    double rest = x - floor(x);
+    long long h2 = 1, k2 = 0, h1 = a, k1 = 1;
+    while (rest != 0) {
+        x = 1 / rest;
+        // Terms beyond maxDenominator are cut by the denominator limit anyway
+        a = x > static_cast<double>(maxDenominator) ? maxDenominator + 1 : static_cast<long long>(floor(x));
+        rest = x - floor(x);
+
+        // Semiconvergents (h2 + t h1) / (k2 + t k1), t = 1..a; t = a is the next convergent
+        const long long tMax = min(a, (maxDenominator - k2) / k1);
+        if (tMax < 1) break;
+        auto distance = [&](long long t) {
+            return fabs(value - static_cast<double>(h2 + t * h1) / static_cast<double>(k2 + t * k1));
+        };
+        if (distance(tMax) < tolerance) {
+            long long lo = 1, hi = tMax;
+            while (lo < hi) {
+                const long long mid = lo + (hi - lo) / 2;
+                if (distance(mid) < tolerance) hi = mid; else lo = mid + 1;
+            }
+            consider(k2 + lo * k1);
+            return;
+        }
+        consider(k2 + tMax * k1);
+        if (tMax < a) break;
+        const long long h = a * h1 + h2, k = a * k1 + k2;
+        h2 = h1; k2 = k1;
+        h1 = h;  k1 = k;
+    }
+}
+
+// Appends value as "p/q", or "p" when it is (close to) an integer, without temporary strings
+inline void appendFraction(string& out, double value, int maxDenominator = 1000) {
+    if (!isfinite(value) || fabs(value) >= 1e18) {
+        // Whole numbers beyond long long; "%.0f" of the largest double is 309 digits
+        char wide[320];
+        const int len = snprintf(wide, sizeof(wide), "%.0f", value);
+        out.append(wide, len);
+        return;
+    }
+    char buf[48];
+    long long num, den;
+    bestFraction(value, maxDenominator, num, den);
+    // At most 20 digits and a sign each, so both halves and the slash always fit
+    char* end = to_chars(buf, buf + 24, num).ptr;
+    if (den != 1) {
+        *end++ = '/';
+        end = to_chars(end, buf + sizeof(buf), den).ptr;
+    }
+    out.append(buf, end - buf);
+}
+
+inline string fractionString(double value, int maxDenominator = 1000) {
+    string s;
+    appendFraction(s, value, maxDenominator);
+    return s;
+}
+
+#endif  // FRACTION_H
@@ -0,0 +1,402 @@
+#ifndef GEMM_H
+#define GEMM_H
+
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include "ThreadPool.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define GEMM_X86_DISPATCH 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// General matrix multiply C = alpha * A * B + beta * C in the Goto/BLIS style:
+// B is packed into kc x nc blocks (L3), A into mc x kc blocks (L2), and a register-tiled
+// mr x nr micro-kernel streams one packed sliver of each through L1.
+// A and B are addressed through (row stride, column stride) so transposed operands need no copy.
+
+namespace gemm_detail {
+
+// Largest register tile of any kernel below (8 x 32 floats)
+constexpr int maxTile = 256;
+
+template <class T>
+using MicroKernel = void (*)(int kc, const T* a, const T* b, T* c, ptrdiff_t ldc, T alpha);
+
+// One micro-kernel and the cache blocking tuned for it
+template <class T>
+struct Kernel {
+    const char* name;
+    int mr, nr;              // register tile
+    int mc, kc, nc;          // L2 / L1 / L3 blocking
+    MicroKernel<T> micro;    // C[0:mr, 0:nr] += alpha * Ap * Bp for one packed sliver pair
+};
+
+// Portable kernel: the accumulator tile lives in a local array the compiler can keep in registers
+template <class T, int MR, int NR>
+void microScalar(int kc, const T* a, const T* b, T* c, ptrdiff_t ldc, T alpha) {
+    T acc[MR][NR] = {};
+    for (int p = 0; p < kc; p++, a += MR, b += NR) {
+        for (int i = 0; i < MR; i++) {
+            const T ai = a[i];
+            for (int j = 0; j < NR; j++) {
+                acc[i][j] += ai * b[j];
+            }
+        }
+    }
+    for (int i = 0; i < MR; i++) {
+        for (int j = 0; j < NR; j++) {
+            c[i * ldc + j] += alpha * acc[i][j];
+        }
+    }
+}
+
+#ifdef GEMM_X86_DISPATCH
+
+// AVX2 + FMA: 6 x 8 doubles, 12 ymm accumulators
+__attribute__((target("avx2,fma")))
+inline void microAvx2(int kc, const double* a, const double* b, double* c, ptrdiff_t ldc, double alpha) {
+    __m256d acc[6][2];
+#pragma GCC unroll 6
+    for (int i = 0; i < 6; i++) {
+        acc[i][0] = _mm256_setzero_pd();
+        acc[i][1] = _mm256_setzero_pd();
+    }
+    for (int p = 0; p < kc; p++, a += 6, b += 8) {
+        const __m256d b0 = _mm256_loadu_pd(b);
+        const __m256d b1 = _mm256_loadu_pd(b + 4);
+#pragma GCC unroll 6
+        for (int i = 0; i < 6; i++) {
+            const __m256d ai = _mm256_broadcast_sd(a + i);
+            acc[i][0] = _mm256_fmadd_pd(ai, b0, acc[i][0]);
+            acc[i][1] = _mm256_fmadd_pd(ai, b1, acc[i][1]);
+        }
+    }
+    const __m256d al = _mm256_set1_pd(alpha);
+#pragma GCC unroll 6
+    for (int i = 0; i < 6; i++) {
+        double* ci = c + i * ldc;
+        _mm256_storeu_pd(ci, _mm256_fmadd_pd(al, acc[i][0], _mm256_loadu_pd(ci)));
+        _mm256_storeu_pd(ci + 4, _mm256_fmadd_pd(al, acc[i][1], _mm256_loadu_pd(ci + 4)));
+    }
+}
+
+// AVX2 + FMA: 6 x 16 floats
+__attribute__((target("avx2,fma")))
+inline void microAvx2(int kc, const float* a, const float* b, float* c, ptrdiff_t ldc, float alpha) {
+    __m256 acc[6][2];
+#pragma GCC unroll 6
+    for (int i = 0; i < 6; i++) {
+        acc[i][0] = _mm256_setzero_ps();
+        acc[i][1] = _mm256_setzero_ps();
+    }
+    for (int p = 0; p < kc; p++, a += 6, b += 16) {
+        const __m256 b0 = _mm256_loadu_ps(b);
+        const __m256 b1 = _mm256_loadu_ps(b + 8);
+#pragma GCC unroll 6
+        for (int i = 0; i < 6; i++) {
+            const __m256 ai = _mm256_broadcast_ss(a + i);
+            acc[i][0] = _mm256_fmadd_ps(ai, b0, acc[i][0]);
+            acc[i][1] = _mm256_fmadd_ps(ai, b1, acc[i][1]);
+        }
+    }
+    const __m256 al = _mm256_set1_ps(alpha);
+#pragma GCC unroll 6
+    for (int i = 0; i < 6; i++) {
+        float* ci = c + i * ldc;
+        _mm256_storeu_ps(ci, _mm256_fmadd_ps(al, acc[i][0], _mm256_loadu_ps(ci)));
+        _mm256_storeu_ps(ci + 8, _mm256_fmadd_ps(al, acc[i][1], _mm256_loadu_ps(ci + 8)));
+    }
+}
+
+// AVX-512F: 8 x 16 doubles, 16 zmm accumulators
+__attribute__((target("avx512f")))
+inline void microAvx512(int kc, const double* a, const double* b, double* c, ptrdiff_t ldc, double alpha) {
+    __m512d acc[8][2];
+#pragma GCC unroll 8
+    for (int i = 0; i < 8; i++) {
+        acc[i][0] = _mm512_setzero_pd();
+        acc[i][1] = _mm512_setzero_pd();
+    }
+    for (int p = 0; p < kc; p++, a += 8, b += 16) {
+        const __m512d b0 = _mm512_loadu_pd(b);
+        const __m512d b1 = _mm512_loadu_pd(b + 8);
+#pragma GCC unroll 8
+        for (int i = 0; i < 8; i++) {
+            const __m512d ai = _mm512_set1_pd(a[i]);
+            acc[i][0] = _mm512_fmadd_pd(ai, b0, acc[i][0]);
+            acc[i][1] = _mm512_fmadd_pd(ai, b1, acc[i][1]);
+        }
+    }
+    const __m512d al = _mm512_set1_pd(alpha);
+#pragma GCC unroll 8
+    for (int i = 0; i < 8; i++) {
+        double* ci = c + i * ldc;
+        _mm512_storeu_pd(ci, _mm512_fmadd_pd(al, acc[i][0], _mm512_loadu_pd(ci)));
+        _mm512_storeu_pd(ci + 8, _mm512_fmadd_pd(al, acc[i][1], _mm512_loadu_pd(ci + 8)));
+    }
+}
+
+// AVX-512F: 8 x 32 floats
+__attribute__((target("avx512f")))
+inline void microAvx512(int kc, const float* a, const float* b, float* c, ptrdiff_t ldc, float alpha) {
+    __m512 acc[8][2];
+#pragma GCC unroll 8
+    for (int i = 0; i < 8; i++) {
+        acc[i][0] = _mm512_setzero_ps();
+        acc[i][1] = _mm512_setzero_ps();
+    }
+    for (int p = 0; p < kc; p++, a += 8, b += 32) {
+        const __m512 b0 = _mm512_loadu_ps(b);
+        const __m512 b1 = _mm512_loadu_ps(b + 16);
+#pragma GCC unroll 8
+        for (int i = 0; i < 8; i++) {
+            const __m512 ai = _mm512_set1_ps(a[i]);
+            acc[i][0] = _mm512_fmadd_ps(ai, b0, acc[i][0]);
+            acc[i][1] = _mm512_fmadd_ps(ai, b1, acc[i][1]);
+        }
+    }
+    const __m512 al = _mm512_set1_ps(alpha);
+#pragma GCC unroll 8
+    for (int i = 0; i < 8; i++) {
+        float* ci = c + i * ldc;
+        _mm512_storeu_ps(ci, _mm512_fmadd_ps(al, acc[i][0], _mm512_loadu_ps(ci)));
+        _mm512_storeu_ps(ci + 16, _mm512_fmadd_ps(al, acc[i][1], _mm512_loadu_ps(ci + 16)));
+    }
+}
+
+inline bool cpuHasAvx2() {
+    static const bool has = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return has;
+}
+
+inline bool cpuHasAvx512() {
+    static const bool has = __builtin_cpu_supports("avx512f");
+    return has;
+}
+
+#endif  // GEMM_X86_DISPATCH
+
+// Kernel selection happens once per element type, on first use.
+// Blocking keeps a kc x nr sliver of B in L1, an mc x kc block of A in L2 and kc x nc of B in L3.
+template <class T>
+inline Kernel<T> selectKernel() {
+    return {"scalar", 4, 4, 64, 128, 2048, &microScalar<T, 4, 4>};
+}
+
+template <>
+inline Kernel<double> selectKernel<double>() {
+#ifdef GEMM_X86_DISPATCH
+    if (cpuHasAvx512()) return {"avx512", 8, 16, 128, 192, 4096, &microAvx512};
+    if (cpuHasAvx2()) return {"avx2", 6, 8, 72, 256, 4080, &microAvx2};
+#endif
+    return {"scalar", 4, 4, 64, 256, 2048, &microScalar<double, 4, 4>};
+}
+
+template <>
+inline Kernel<float> selectKernel<float>() {
+#ifdef GEMM_X86_DISPATCH
+    if (cpuHasAvx512()) return {"avx512", 8, 32, 128, 256, 4096, &microAvx512};
+    if (cpuHasAvx2()) return {"avx2", 6, 16, 120, 384, 4080, &microAvx2};
+#endif
+    return {"scalar", 4, 8, 64, 256, 2048, &microScalar<float, 4, 8>};
+}
+
+template <class T>
+const Kernel<T>& kernel() {
+    static const Kernel<T> k = selectKernel<T>();
+    return k;
+}
+
+// Copy an mb x kb block of A into mr-row slivers: sliver s holds A(s*mr + i, p) at [s*mr*kb + p*mr + i].
+// Rows past mb are zero-filled so every sliver can go through the full-size kernel.
+template <class T>
+void packA(int mb, int kb, const T* a, ptrdiff_t rs, ptrdiff_t cs, int mr, T* out) {
+    for (int ir = 0; ir < mb; ir += mr) {
+        const int rows = min(mr, mb - ir);
+        for (int p = 0; p < kb; p++) {
+            const T* src = a + ir * rs + p * cs;
+            int i = 0;
+            for (; i < rows; i++) out[i] = src[i * rs];
+            for (; i < mr; i++) out[i] = T(0);
+            out += mr;
+        }
+    }
+}
+
+// Copy a kb x nb block of B into nr-column slivers: sliver s holds B(p, s*nr + j) at [s*nr*kb + p*nr + j]
+template <class T>
+void packB(int kb, int nb, const T* b, ptrdiff_t rs, ptrdiff_t cs, int nr, T* out) {
+    for (int jr = 0; jr < nb; jr += nr) {
+        const int cols = min(nr, nb - jr);
+        for (int p = 0; p < kb; p++) {
+            const T* src = b + p * rs + jr * cs;
+            int j = 0;
+            if (cs == 1) {
+                for (; j < cols; j++) out[j] = src[j];
+            } else {
+                for (; j < cols; j++) out[j] = src[j * cs];
+            }
+            for (; j < nr; j++) out[j] = T(0);
+            out += nr;
+        }
+    }
+}
+
+// Packing buffers come from a per-thread stack that is reused across calls, so steady-state
+// products do not allocate. The stack (rather than one buffer) keeps a thread that picks up
+// another product while waiting inside parallelFor from overwriting a buffer still in use.
+template <class T>
+class Workspace {
+public:
+    explicit Workspace(size_t n) {
+        Stack& s = stack();
+        if (s.top == s.buffers.size()) s.buffers.emplace_back();
+        vector<T>& buf = s.buffers[s.top++];
+        if (buf.size() < n) buf.resize(n);
+        ptr = buf.data();
+    }
+    ~Workspace() { stack().top--; }
+    Workspace(const Workspace&) = delete;
+    Workspace& operator=(const Workspace&) = delete;
+
+    T* data() const { return ptr; }
+
+private:
+    struct Stack {
+        vector<vector<T>> buffers;
+        size_t top = 0;
+    };
+    static Stack& stack() {
+        thread_local Stack s;
+        return s;
+    }
+    T* ptr;
+};
+
+// C = beta * C before accumulating; beta == 0 overwrites so NaN/Inf in C do not leak through
+template <class T>
+void scaleC(int m, int n, T beta, T* c, ptrdiff_t ldc) {
+    if (beta == T(1)) return;
+    for (int i = 0; i < m; i++) {
+        T* ci = c + i * ldc;
+        if (beta == T(0)) {
+            fill(ci, ci + n, T(0));
+        } else {
+            for (int j = 0; j < n; j++) ci[j] *= beta;
+        }
+    }
+}
+
+// Multiply one packed mb x kb block of A against the packed kb x nb panel of B
+template <class T>
+void macroKernel(const Kernel<T>& k, int mb, int nb, int kb, T alpha, const T* ap, const T* bp, T* c, ptrdiff_t ldc) {
+    for (int jr = 0; jr < nb; jr += k.nr) {
+        const int cols = min(k.nr, nb - jr);
+        const T* bs = bp + static_cast<size_t>(jr) * kb;
+        for (int ir = 0; ir < mb; ir += k.mr) {
+            const int rows = min(k.mr, mb - ir);
+            const T* as = ap + static_cast<size_t>(ir) * kb;
+            T* cij = c + ir * ldc + jr;
+            if (rows == k.mr && cols == k.nr) {
+                k.micro(kb, as, bs, cij, ldc, alpha);
+            } else {
+                // Edge tile: run the full kernel on a scratch tile and add back only the valid part
+                T tile[maxTile] = {};
+                k.micro(kb, as, bs, tile, k.nr, alpha);
+                for (int i = 0; i < rows; i++) {
+                    for (int j = 0; j < cols; j++) {
+                        cij[i * ldc + j] += tile[i * k.nr + j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+}  // namespace gemm_detail
+
+// Below this many multiply-adds packing costs more than it saves
+constexpr long long gemmSmallThreshold = 32LL * 32 * 32;
+
+// C (m x n, row stride ldc) = alpha * A (m x k) * B (k x n) + beta * C.
+// Element (i, p) of A is A[i * rsA + p * csA]; likewise for B.
+template <class T>
+void gemm(int m, int n, int k, T alpha,
+          const T* A, ptrdiff_t rsA, ptrdiff_t csA,
+          const T* B, ptrdiff_t rsB, ptrdiff_t csB,
+          T beta, T* C, ptrdiff_t ldc) {
+    using namespace gemm_detail;
+    if (m <= 0 || n <= 0) return;
+    scaleC(m, n, beta, C, ldc);
+    if (k <= 0 || alpha == T(0)) return;
+
+    if (static_cast<long long>(m) * n * k <= gemmSmallThreshold) {
+        for (int i = 0; i < m; i++) {
+            T* ci = C + i * ldc;
+            for (int p = 0; p < k; p++) {
+                const T aip = alpha * A[i * rsA + p * csA];
+                const T* bp = B + p * rsB;
+                for (int j = 0; j < n; j++) ci[j] += aip * bp[j * csB];
+            }
+        }
+        return;
+    }
+
+    const Kernel<T>& ker = kernel<T>();
+    Workspace<T> bpBuf(static_cast<size_t>(ker.nc + ker.nr) * ker.kc);
+    T* bp = bpBuf.data();
+
+    for (int jc = 0; jc < n; jc += ker.nc) {
+        const int nb = min(ker.nc, n - jc);
+        const int slivers = (nb + ker.nr - 1) / ker.nr;
+        for (int pc = 0; pc < k; pc += ker.kc) {
+            const int kb = min(ker.kc, k - pc);
+            const T* bBlock = B + pc * rsB + jc * csB;
+            parallelFor(0, slivers, static_cast<size_t>(kb) * ker.nr, [&](size_t lo, size_t hi) {
+                const int j0 = static_cast<int>(lo) * ker.nr;
+                const int j1 = min(nb, static_cast<int>(hi) * ker.nr);
+                packB(kb, j1 - j0, bBlock + j0 * csB, rsB, csB, ker.nr, bp + static_cast<size_t>(j0) * kb);
+            });
+
+            // Tiles are (mc row block) x (column group). Splitting the columns as well keeps
+            // every thread busy when m is small; adjacent tiles share a row block and its packed A.
+            const int rowBlocks = (m + ker.mc - 1) / ker.mc;
+            int groups = 1;
+            const int threads = getNumThreads();
+            while (rowBlocks * groups < 4 * threads && slivers / (groups * 2) >= 4) groups *= 2;
+            const int groupCols = ((slivers + groups - 1) / groups) * ker.nr;
+            const size_t tileWork = static_cast<size_t>(ker.mc) * kb * groupCols;
+
+            parallelFor(0, static_cast<size_t>(rowBlocks) * groups, tileWork, [&](size_t lo, size_t hi) {
+                Workspace<T> apBuf(static_cast<size_t>(ker.mc + ker.mr) * ker.kc);
+                T* ap = apBuf.data();
+                int packed = -1;
+                for (size_t t = lo; t < hi; t++) {
+                    const int ib = static_cast<int>(t) / groups;
+                    const int j0 = (static_cast<int>(t) % groups) * groupCols;
+                    if (j0 >= nb) continue;
+                    const int ic = ib * ker.mc;
+                    const int mb = min(ker.mc, m - ic);
+                    if (ib != packed) {
+                        packA(mb, kb, A + ic * rsA + pc * csA, rsA, csA, ker.mr, ap);
+                        packed = ib;
+                    }
+                    macroKernel(ker, mb, min(groupCols, nb - j0), kb, alpha, ap,
+                                bp + static_cast<size_t>(j0) * kb, C + ic * ldc + jc + j0, ldc);
+                }
+            });
+        }
+    }
+}
+
+// Name of the micro-kernel gemm() dispatches to for T ("avx512", "avx2" or "scalar")
+template <class T>
+const char* gemmKernelName() {
+    return gemm_detail::kernel<T>().name;
+}
+
+#endif  // GEMM_H
@@ -5,17 +5,83 @@
 #include <iostream>
 #include <stdexcept>
 #include <iomanip>
+#include <cstddef>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include "ThreadPool.h"
+#include "Fraction.h"
+#include "Gemm.h"
+#include "Trsm.h"
+#include "MatrixExpr.h"
+#include "Arena.h"
 
 using namespace std;
 
-class Matrix {
+template <class T> class BasicMatrix;
+template <class T> class LUDecomposition;
+template <class T> T det(const BasicMatrix<T>& mat);
+template <class T> void printMatrix(const BasicMatrix<T>& mat);
+
+// Non-owning view of a contiguous run of elements (a minimal std::span)
+template <class T>
+class Span {
 public:
-    
-    Matrix() : row(0), col(0), mtx(0, vector<long double>(0, 0)) {
-        
+    Span() : ptr(nullptr), len(0) {}
+    Span(T* p, size_t n) : ptr(p), len(n) {}
+
+    T* data() const { return ptr; }
+    size_t size() const { return len; }
+    bool empty() const { return len == 0; }
+    T& operator[](size_t k) const { return ptr[k]; }
+    T* begin() const { return ptr; }
+    T* end() const { return ptr + len; }
+
+private:
+    T* ptr;
+    size_t len;
+};
+
+// Edge of the square tiles the transposes work on: two tiles of doubles fit comfortably in L1
+constexpr int transposeTile = 32;
+
+// Cache-oblivious transpose of a rows x cols block (row strides lds / ldd): halve the longer side
+// until the block is a tile, so reads and writes both stay within cache at every level.
+template <class T>
+void transposeBlock(const T* src, size_t lds, T* dst, size_t ldd, int rows, int cols) {
+    if (rows <= transposeTile && cols <= transposeTile) {
+        for (int i = 0; i < rows; i++) {
+            for (int j = 0; j < cols; j++) {
+                dst[j * ldd + i] = src[i * lds + j];
+            }
+        }
+        return;
+    }
+    if (rows >= cols) {
+        const int h = rows / 2;
+        transposeBlock(src, lds, dst, ldd, h, cols);
+        transposeBlock(src + h * lds, lds, dst + h, ldd, rows - h, cols);
+    } else {
+        const int h = cols / 2;
+        transposeBlock(src, lds, dst, ldd, rows, h);
+        transposeBlock(src + h, lds, dst + h * ldd, ldd, rows, cols - h);
     }
+}
 
-    Matrix(vector<vector<long double>> exp) {
+// Dense matrix stored as a single row-major buffer: element (i, j) lives at mtx[i * ld + j]. The row
+// stride ld equals col unless column capacity was reserved (reserve(), append_cols()); copies are packed.
+// T is the element type (float, double or long double); Matrix keeps the original long double behaviour.
+// Storage comes from the heap, or from the current MatrixArena while an ArenaScope is open (Arena.h).
+template <class T>
+class BasicMatrix : public MatrixExpr<BasicMatrix<T>> {
+public:
+    using value_type = T;
+
+    BasicMatrix() : row(0), col(0), ld(0), mtx() {
+
+    }
+
+    BasicMatrix(const vector<vector<T>>& exp) {
 
         if (exp.empty()) {
             throw invalid_argument("Matrix is empty, cannot determine column size.");
@@ -25,44 +91,50 @@ public:
         }
 
 
-        row = exp.size(); 
-        col = exp[0].size();  
-        
-        mtx.resize(row, vector<long double>(col));
+        row = exp.size();
+        col = exp[0].size();
+        ld = col;
+
+        mtx.resize(static_cast<size_t>(row) * col);
         for (int i = 0; i < row; i++) {
-            for (int j = 0; j < col; j++) { 
-                mtx[i][j] = exp[i][j];  
+            if (exp[i].size() != static_cast<size_t>(col)) {
+                throw invalid_argument("All rows must have the same number of columns.");
+            }
+            for (int j = 0; j < col; j++) {
+                mtx[index(i, j)] = exp[i][j];
             }
         }
-        
+
     }
-    
-    Matrix(int x, int y) : row(x), col(y), mtx(x, vector<long double>(y, 0)) {
+
+    BasicMatrix(int x, int y) : row(x), col(y), ld(y) {
         if (x <= 0 || y <= 0) {
          throw invalid_argument("Matrix dimensions must be positive integers.");
         }
+        mtx.assign(static_cast<size_t>(x) * y, T(0));
     }
 
-    Matrix(int r, int c , vector<vector<long double>>& data) : row(r), col(c), mtx(r, vector<long double>(c)) { 
-    
+    BasicMatrix(int r, int c , vector<vector<T>>& data) : row(r), col(c), ld(c) {
+
         if (r <= 0 || c <= 0) {
             throw invalid_argument("Matrix dimensions must be positive integers.");
         }
-    
+        mtx.resize(static_cast<size_t>(r) * c);
+
         for (int i = 0; i < row; i++) {
-            for (int j = 0; j < col; j++) { 
-                mtx[i][j] = data[i][j]; 
+            for (int j = 0; j < col; j++) {
+                mtx[index(i, j)] = data[i][j];
             }
         }
-    
+
     }
 
 
     void display(){
 
-        for (const auto& row : mtx) { 
-            for (const auto& elem : row) {
-               cout << elem << " ";
+        for (int i = 0; i < row; i++) {
+            for (int j = 0; j < col; j++) {
+               cout << mtx[index(i, j)] << " ";
             }
             cout << endl;
         }
@@ -70,149 +142,243 @@ public:
     }
 
 
-    void print() {
-    // Print the top border of the matrix (adjusted to be wider)
-    //cout << "+-----------------------------------------+" << endl;
+    // Bordered table of fractions (see Fraction.h), built in one buffer and written at once
+    void print() const { print(cout); }
 
-    cout << "+";
-    for(int i=0;i<14*col-1;i++){
-        cout << "-";
+    void print(ostream& os) const {
+        const string table = toString();
+        os.write(table.data(), static_cast<streamsize>(table.size()));
+        os.flush();
     }
-    cout << "+" << endl;
-    
-    // Iterate through each row
-    for (const auto& row : mtx) {
-        cout << "| "; // Start of row
-        // Iterate through each element in the row
-        for (const auto& elem : row) {
-            // Print the fraction with center alignment
-            cout << setw(7) << internal << doubleToFraction(elem)<< setw(7) << " | ";
-        }
-        cout << endl;
-
-        // Print a separator line after each row
-        cout << "+";
-        for(int i=0;i<14*col-1;i++){
-           cout << "-";
-        }
-       
-        cout << "+" << endl;
 
-       // cout << "+-----------------------------------------+" << endl;
-    }
-    cout <<endl;
+    // The table print() writes. Rows are rendered independently, so large matrices format them in parallel.
+    string toString() const {
+        const string border = "+" + string(max(0, 14 * col - 1), '-') + "+\n";
+        vector<string> lines(row);
+        parallelFor(0, row, static_cast<size_t>(col) * 256, [&](size_t lo, size_t hi) {
+            string cell;
+            for (size_t r = lo; r < hi; r++) {
+                string& line = lines[r];
+                line.reserve(14 * static_cast<size_t>(col) + border.size() + 4);
+                line += "| ";
+                for (int c = 0; c < col; c++) {
+                    // Right-aligned in 7 columns, then a padded separator, as setw(7) used to print them
+                    cell.clear();
+                    appendFraction(cell, static_cast<double>(mtx[index(static_cast<int>(r), c)]));
+                    if (cell.size() < 7) line.append(7 - cell.size(), ' ');
+                    line += cell;
+                    line += "     | ";
+                }
+                line += '\n';
+                line += border;
+            }
+        });
+        size_t total = border.size() + 1;
+        for (const string& line : lines) total += line.size();
+        string table;
+        table.reserve(total);
+        table += border;
+        for (const string& line : lines) table += line;
+        table += '\n';
+        return table;
     }
-    
+
     void fillMatrix() {
         cout << "Enter matrix elements: \n";
         for (int i = 0; i < row; i++) {
             for (int j = 0; j < col; j++) {
-                cin >> mtx[i][j];
+                cin >> mtx[index(i, j)];
             }
         }
     }
 
-    Matrix operator+(const Matrix& other) { 
-
-	if(other.getCol() != col || other.getRow() != row){
-		throw runtime_error("Matrix dimensions do not match for addition!");
-	} 
-
-	Matrix result(row, col); 
-
-	for (int i = 0; i < row; i++) {
-		for (int j = 0; j < col; j++) {
-			result.mtx[i][j] = mtx[i][j] + other.mtx[i][j];
-		}
-	}
-
-
-	return result; 
-    }
-
-    bool operator==(const Matrix& other) {
+    bool operator==(const BasicMatrix& other) const {
 	if (other.getCol() != col || other.getRow() != row) {
 		cout << "erorr";
 		return 0;
 	}
 
+	if (ld == col && other.ld == other.col) return mtx == other.mtx;
 	for (int i = 0; i < row; i++) {
-		for (int j = 0; j < col; j++) {
-			if (mtx[i][j] != other.mtx[i][j]) {
-				return 0;
-			}
+		if (!equal(mtx.begin() + index(i, 0), mtx.begin() + index(i, 0) + col, other.mtx.begin() + other.index(i, 0))) {
+			return false;
 		}
 	}
-
-	return 1;
+	return true;
     }
 
-    void operator=(const Matrix& other) {
-	if (this == &other) return; // Handle self-assignment
-    if (other.getCol() != col || other.getRow() != row) {
-        throw runtime_error("Matrix dimensions do not match for assignment.");
+    // Value semantics: copies are deep (and packed, like a copied vector drops its spare capacity), moves steal
+    // the buffer and leave the source as an empty 0 x 0 matrix, and assignment takes on the dimensions of the
+    // right-hand side.
+    BasicMatrix(const BasicMatrix& other) : row(other.row), col(other.col), ld(other.col) {
+        if (other.ld == other.col) {
+            mtx = other.mtx;
+        } else {
+            mtx.resize(static_cast<size_t>(row) * col);
+            other.copyPacked(mtx.data());
+        }
     }
 
-	for (int i = 0; i < row; i++) {
-		for (int j = 0; j < col; j++) {
-			
-			mtx[i][j] = other.mtx[i][j];
-				
-		}
-	}
+    BasicMatrix(BasicMatrix&& other) noexcept : row(other.row), col(other.col), ld(other.ld), mtx(std::move(other.mtx)) {
+        other.row = 0;
+        other.col = 0;
+        other.ld = 0;
     }
 
-    Matrix operator+(const long double scalar) const { 
-	Matrix result(row, col);
-	for (int i = 0; i < row; ++i) {
-		for (int j = 0; j < col; ++j) {
-			result.mtx[i][j] = this->mtx[i][j] + scalar;
-		}
+    BasicMatrix& operator=(const BasicMatrix& other) {
+	if (this == &other) return *this; // Handle self-assignment
+	row = other.row;
+	col = other.col;
+	ld = other.col;
+	if (other.ld == other.col) {
+		mtx = other.mtx;  // reuses the existing buffer when it is large enough
+	} else {
+		mtx.resize(static_cast<size_t>(row) * col);
+		other.copyPacked(mtx.data());
 	}
-	return result;
+	return *this;
     }
 
+    // Takes other's buffer, and with it other's arena (if any)
+    BasicMatrix& operator=(BasicMatrix&& other) noexcept {
+	if (this == &other) return *this;
+	row = other.row;
+	col = other.col;
+	ld = other.ld;
+	mtx = std::move(other.mtx);
+	other.row = 0;
+	other.col = 0;
+	other.ld = 0;
+	return *this;
+    }
 
-    Matrix operator*(const long double scalar) const {
-	Matrix result(row, col);
-	for (int i = 0; i < row; ++i) {
-		for (int j = 0; j < col; ++j) {
-			result.mtx[i][j] = mtx[i][j] * scalar; 
-		}
-	}
-	return result;
+    // Element-wise arithmetic (+, -, scalar *, /) builds expression templates (MatrixExpr.h);
+    // constructing or assigning a Matrix from one evaluates it in a single fused pass.
+    template <class E>
+    BasicMatrix(const MatrixExpr<E>& e) : row(e.self().getRow()), col(e.self().getCol()), ld(col) {
+        mtx.resize(static_cast<size_t>(row) * col);
+        evaluate(e.self());
     }
 
-    Matrix operator/(const long double scalar) const {
-	if (scalar == 0) {
-		throw runtime_error("Division by zero!"); 
+    template <class E>
+    BasicMatrix& operator=(const MatrixExpr<E>& e) {
+	if (e.self().getCol() != col || e.self().getRow() != row) {
+		// The expression may read this matrix, so build the resized result aside before replacing it
+		return *this = BasicMatrix(e);
 	}
-	Matrix result(row, col);
-	for (int i = 0; i < row; ++i) {
-		for (int j = 0; j < col; ++j) {
-			result.mtx[i][j] = mtx[i][j] / scalar;
-		}
+	if (wrapOperand(e).aliases(assignTarget())) {
+		// A = A.transposeView() reads elements after they are overwritten: evaluate it aside first
+		const BasicMatrix result(e);
+		evaluate(MatrixLeaf<T>(result));
+		return *this;
 	}
-	return result;
+	// Every element is read and written at the same (i, j), so A = A + B is safe in place
+	evaluate(e.self());
+	return *this;
+    }
+
+    template <class E>
+    BasicMatrix& operator+=(const MatrixExpr<E>& e) {
+	if (wrapOperand(e).aliases(assignTarget())) return *this += BasicMatrix(e);
+	evaluate(BinaryExpr<AddOp, MatrixLeaf<T>, expr_operand_t<E>>(MatrixLeaf<T>(*this), wrapOperand(e), "addition"));
+	return *this;
     }
 
+    template <class E>
+    BasicMatrix& operator-=(const MatrixExpr<E>& e) {
+	if (wrapOperand(e).aliases(assignTarget())) return *this -= BasicMatrix(e);
+	evaluate(BinaryExpr<SubOp, MatrixLeaf<T>, expr_operand_t<E>>(MatrixLeaf<T>(*this), wrapOperand(e), "subtraction"));
+	return *this;
+    }
 
+    BasicMatrix& operator+=(const T scalar) {
+	evaluate(*this + scalar);
+	return *this;
+    }
 
-    Matrix transpose() const {
+    BasicMatrix& operator-=(const T scalar) {
+	evaluate(*this - scalar);
+	return *this;
+    }
 
-    vector<vector<long double>> transposed(col, vector<long double>(row));
+    BasicMatrix& operator*=(const T scalar) {
+	evaluate(*this * scalar);
+	return *this;
+    }
+
+    BasicMatrix& operator/=(const T scalar) {
+	evaluate(*this / scalar);
+	return *this;
+    }
 
-    for (int i = 0; i < row; i++) {
-        for (int j = 0; j < col; j++) {
-            transposed[j][i] = mtx[i][j];
+    // C = alpha * (*this) * B + beta * C without allocating; C must already be getRow() x B.getCol()
+    void multiply_into(const BasicMatrix& B, BasicMatrix& C, T alpha = 1, T beta = 0) const {
+	if (col != B.getRow() || C.getRow() != row || C.getCol() != B.getCol()) {
+		throw runtime_error("Matrix dimensions do not match for multiplication!");
+	}
+	if (&C == this || &C == &B) {
+		throw invalid_argument("multiply_into: output must not alias an input.");
+	}
+	gemm<T>(row, B.col, col, alpha,
+	        mtx.data(), ld, 1,
+	        B.mtx.data(), B.ld, 1,
+	        beta, C.mtx.data(), C.ld);
+    }
+
+    // Out-of-place transpose written straight into the result, tile by tile (see transposeBlock)
+    BasicMatrix transpose() const {
+
+    BasicMatrix transposed(col, row);
+
+    const T* a = mtx.data();
+    T* t = transposed.mtx.data();
+    const int r = row, c = col;
+    const size_t lda = ld;
+    const int stripe = transposeTile * 2;
+    parallelFor(0, (row + stripe - 1) / stripe, static_cast<size_t>(stripe) * col, [=](size_t lo, size_t hi) {
+        const int i0 = static_cast<int>(lo) * stripe;
+        const int i1 = min(r, static_cast<int>(hi) * stripe);
+        transposeBlock(a + static_cast<size_t>(i0) * lda, lda, t + i0, r, i1 - i0, c);
+    });
+    return transposed;
+    }
+
+    // Square matrices swap mirrored tiles in place; other shapes fall back to transpose()
+    void transposeInPlace() {
+    if (row != col) {
+        *this = transpose();
+        return;
+    }
+    const int n = row;
+    const size_t lda = ld;
+    const int tiles = (n + transposeTile - 1) / transposeTile;
+    T* a = mtx.data();
+    // Task bi owns every tile pair (bi, bj) with bj >= bi, so tasks never touch the same element
+    parallelFor(0, tiles, static_cast<size_t>(transposeTile) * n, [=](size_t lo, size_t hi) {
+        for (size_t bi = lo; bi < hi; bi++) {
+            const int i0 = static_cast<int>(bi) * transposeTile;
+            const int i1 = min(n, i0 + transposeTile);
+            for (int j0 = i0; j0 < n; j0 += transposeTile) {
+                const int j1 = min(n, j0 + transposeTile);
+                for (int i = i0; i < i1; i++) {
+                    for (int j = (j0 == i0 ? i + 1 : j0); j < j1; j++) {
+                        swap(a[i * lda + j], a[j * lda + i]);
+                    }
+                }
+            }
         }
+    });
     }
-    return Matrix(transposed);
+
+    // Lazy transpose: reads this matrix with swapped strides. GEMM consumes it without a copy,
+    // and it can appear in element-wise expressions; valid while this matrix is alive and unresized.
+    TransposedView<T> transposeView() const {
+        return TransposedView<T>(*this);
     }
 
 
-    // Recursive helper function for determinant calculation 
-    long double determinantRecursive(const vector<vector<long double>>& matrix) const {
+    // Recursive helper function for determinant calculation
+    T determinantRecursive(const vector<vector<T>>& matrix) const {
         if (row != col) {
          throw invalid_argument("Matrix must be square .");
         }
@@ -224,10 +390,10 @@ public:
             return matrix[0][0] * matrix[1][1] - matrix[0][1] * matrix[1][0];  // 2x2 case
         }
 
-        long double det = 0;
+        T det = 0;
 
         for (int i = 0; i < n; i++) {
-            vector<vector<long double>> minor = getMinorMatrix(matrix, 0, i);  // Get the minor matrix
+            vector<vector<T>> minor = getMinorMatrix(matrix, 0, i);  // Get the minor matrix
             det += (i % 2 == 0 ? 1 : -1) * matrix[0][i] * determinantRecursive(minor);
         }
 
@@ -236,13 +402,13 @@ public:
 
 
     // Get the minor of a matrix by excluding the given row and column
-    vector<vector<long double>> getMinorMatrix(const vector<vector<long double>>& matrix, int row, int col) const {
-        vector<vector<long double>> minor;
-        for (int i = 0; i < matrix.size(); i++) {
-            if (i == row) continue;
-            vector<long double> newRow;
-            for (int j = 0; j < matrix[i].size(); j++) {
-              if (j == col) continue;
+    vector<vector<T>> getMinorMatrix(const vector<vector<T>>& matrix, int row, int col) const {
+        vector<vector<T>> minor;
+        for (size_t i = 0; i < matrix.size(); i++) {
+            if (static_cast<int>(i) == row) continue;
+            vector<T> newRow;
+            for (size_t j = 0; j < matrix[i].size(); j++) {
+              if (static_cast<int>(j) == col) continue;
               newRow.push_back(matrix[i][j]);
             }
         minor.push_back(newRow);
@@ -250,195 +416,646 @@ public:
     return minor;
     }
 
-    void identity() { 
+    void identity() {
 
 	if (row != col) {
 		cout << "Identity matrix is only for square matrices!" << endl;
 		return;
 	}
 
+	fill(mtx.begin(), mtx.end(), T(0));
 	for (int i = 0; i < row; i++) {
+		mtx[index(i, i)] = 1;
+	}
 
-		for (int j = 0; j < row; j++) {
-			
-			if (i == j) {
-				mtx[i][j] = 1; 
-			}
-			else{
-				mtx[i][j] = 0;  
-			}
-			
-		}
+    }
 
+    // Both checks factorize once with partial pivoting instead of expanding the determinant
+    bool isInvertible() const {
+	    return !lu().isSingular();
     }
 
+    bool isSingular() const {
+	    return lu().isSingular();
     }
-    
-    bool isInvertible() {
-    	if (det(*this) == 0) {
-	    	return 0;
-	    }
-	    else {
-		    return 1;
-	    }
+
+    // Singular to working precision (see LUDecomposition::isNearlySingular); isSingular() means an exact zero pivot
+    bool isNearlySingular() const {
+	    return lu().isNearlySingular();
     }
 
-    bool isSingular() { 
-	    if (det(*this) == 0) {
-		    return 1;
-	    }
-	    else {
-		    return 0;
-	    }
+    // Pivoted LU factorization of this (square) matrix, reusable for det, inverse and solves
+    LUDecomposition<T> lu() const {
+        return LUDecomposition<T>(*this);
     }
 
 
 
-    void add_row(vector<long double>& new_row){ 
+    // Capacity for up to rows x cols elements: appends within it never move existing elements, and spare
+    // columns make the row stride (getLd()) wider than getCol(). Growth past the capacity is geometric in
+    // both directions, so appending one row or one column costs amortized O(cols) or O(rows).
+    void reserve(int rows, int cols) {
+        if (rows < 0 || cols < 0) {
+            throw invalid_argument("Matrix capacity must not be negative.");
+        }
+        if (cols > ld) {
+            Storage grown = relaidOut(cols, max(rows, row));
+            mtx.swap(grown);
+            ld = cols;
+        }
+        mtx.reserve(static_cast<size_t>(max(rows, row)) * ld);
+    }
+
+    // Releases spare row and column capacity (getLd() == getCol() afterwards)
+    void shrink_to_fit() {
+        if (ld != col) {
+            Storage packed = relaidOut(col, row);
+            mtx.swap(packed);
+            ld = col;
+        }
+        mtx.shrink_to_fit();
+    }
+
+    void add_row(vector<T>& new_row){
 
         // add empty condition
         if (new_row.empty()) {
             throw invalid_argument("The new row must not be empty.");
         }
- 
-        if (col != new_row.size()) {
+
+        if (static_cast<size_t>(col) != new_row.size()) {
             throw invalid_argument("Row length must be equal to col. ");
         }
 
-
-        
-        mtx.push_back(new_row);
-        row++;
-
+        append_rows(BlockView<const T>(new_row.data(), col, 1, col));
     }
 
-    void add_col(vector<long double>& new_col) {
+    void add_col(vector<T>& new_col) {
     // Check if the new column is empty
     if (new_col.empty()) {
         throw invalid_argument("The new column must not be empty.");
     }
 
     // Ensure the new column size matches the number of rows
-    if (row != new_col.size()) {
+    if (static_cast<size_t>(row) != new_col.size()) {
         throw invalid_argument("The number of elements in the new column must match the number of rows.");
     }
 
-    // Add the new column to each row of the matrix
-    for (int i = 0; i < row; i++) {
-        mtx[i].push_back(new_col[i]);
+    append_cols(BlockView<const T>(new_col.data(), 1, row, 1));
     }
 
-    // Increment the column count
-    col++;
+    // Appends the rows of a block (a matrix, view or expression with getCol() columns) below the
+    // existing ones; an empty 0 x 0 matrix takes the block's width. The block may read this matrix.
+    template <class E>
+    void append_rows(const MatrixExpr<E>& e) {
+        const E& b = e.self();
+        const int k = b.getRow();
+        if (row == 0 && col == 0) {
+            if (k == 0) return;
+            col = b.getCol();
+            ld = max(ld, col);  // keeps column capacity reserved up front
+        } else if (b.getCol() != col) {
+            throw invalid_argument("Row length must be equal to col. ");
+        }
+        if (k == 0) return;
+        const size_t need = static_cast<size_t>(row + k) * ld;
+        if (need <= mtx.capacity()) {
+            // No reallocation, so whatever the block reads stays where it is
+            mtx.resize(need);
+            writeBlock(mtx.data(), ld, row, 0, b);
+        } else {
+            // The old buffer outlives the copy, so the block may still read it
+            Storage grown(mtx.get_allocator());
+            grown.reserve(max(need, 2 * mtx.capacity()));
+            grown.assign(mtx.begin(), mtx.end());
+            grown.resize(need);
+            writeBlock(grown.data(), ld, row, 0, b);
+            mtx.swap(grown);
+        }
+        row += k;
     }
 
-    void setElementAt(int row1, int col1, long double elem) {
+    // Appends the columns of a block with getRow() rows to the right of the existing ones, into spare
+    // column capacity when there is enough; otherwise the row stride at least doubles first.
+    // An empty 0 x 0 matrix takes the block's height. The block may read this matrix.
+    template <class E>
+    void append_cols(const MatrixExpr<E>& e) {
+        const E& b = e.self();
+        const int k = b.getCol();
+        if (row == 0 && col == 0) {
+            if (k == 0) return;
+            row = b.getRow();
+            mtx.resize(static_cast<size_t>(row) * ld);
+        } else if (b.getRow() != row) {
+            throw invalid_argument("The number of elements in the new column must match the number of rows.");
+        }
+        if (k == 0) return;
+        if (col + k <= ld) {
+            // Only the spare columns are written; the block cannot see them
+            writeBlock(mtx.data(), ld, 0, col, b);
+        } else {
+            const int grownLd = max(col + k, 2 * ld);
+            const size_t rowCapacity = ld > 0 ? max(mtx.capacity() / ld, static_cast<size_t>(row)) : row;
+            Storage grown = relaidOut(grownLd, rowCapacity);
+            writeBlock(grown.data(), grownLd, 0, col, b);
+            mtx.swap(grown);
+            ld = grownLd;
+        }
+        col += k;
+    }
+
+    void setElementAt(int row1, int col1, T elem) {
 	    if (row1 < 0 || row1 >= row || col1 < 0 || col1 >= col) {
 		    throw runtime_error("Index out of bounds!");
 	    }
-	
 
-	mtx[row1][col1] = elem;
+
+	mtx[index(row1, col1)] = elem;
     }
 
-    long double getElementAt(int row1, int col1) {
+    T getElementAt(int row1, int col1) const {
 	    if (row1 < 0 || row1 >= row || col1 < 0 || col1 >= col) {
 		    throw runtime_error("Index out of bounds!");
 	    }
-	
 
-	return mtx[row1][col1];
+
+	return mtx[index(row1, col1)];
     }
 
+    // Unchecked element access for inner loops (use getElementAt/setElementAt for bounds checking)
+    T& operator()(int i, int j) { return mtx[index(i, j)]; }
+    const T& operator()(int i, int j) const { return mtx[index(i, j)]; }
+
     // Getters
     int getRow() const { return row; }
     int getCol() const { return col; }
-    vector<vector<long double>> getMatrix() const { return mtx; } 
+    // Row i starts at data() + i * getLd(); getLd() == getCol() unless column capacity is reserved
+    T* data() { return mtx.data(); }
+    const T* data() const { return mtx.data(); }
+    int getLd() const { return ld; }
+    // The arena this matrix's storage comes from, or nullptr for the heap
+    MatrixArena* getArena() const { return mtx.get_allocator().getArena(); }
+
+    // Non-owning views: no copy, valid until the matrix is resized or destroyed
+    Span<T> rowView(int i) {
+        if (i < 0 || i >= row) throw runtime_error("Index out of bounds!");
+        return Span<T>(mtx.data() + index(i, 0), col);
+    }
+    Span<const T> rowView(int i) const {
+        if (i < 0 || i >= row) throw runtime_error("Index out of bounds!");
+        return Span<const T>(mtx.data() + index(i, 0), col);
+    }
+    // The whole buffer, row stride getLd() (so it includes spare column capacity, if any)
+    Span<T> dataView() { return Span<T>(mtx.data(), mtx.size()); }
+    Span<const T> dataView() const { return Span<const T>(mtx.data(), mtx.size()); }
+
+    // Blocks used in place (MatrixExpr.h): reads and writes go to this matrix, and the views work in
+    // expressions, products and solves. Valid until the matrix is resized or destroyed.
+    BlockView<T> block(int r0, int c0, int rows, int cols) {
+        checkBlock(r0, c0, rows, cols);
+        return BlockView<T>(mtx.data() + index(r0, c0), ld, rows, cols);
+    }
+    BlockView<const T> block(int r0, int c0, int rows, int cols) const {
+        checkBlock(r0, c0, rows, cols);
+        return BlockView<const T>(mtx.data() + index(r0, c0), ld, rows, cols);
+    }
+
+    // Rows [r0, r1) or columns [c0, c1)
+    BlockView<T> rowRange(int r0, int r1) { return block(r0, 0, r1 - r0, col); }
+    BlockView<const T> rowRange(int r0, int r1) const { return block(r0, 0, r1 - r0, col); }
+    BlockView<T> colRange(int c0, int c1) { return block(0, c0, row, c1 - c0); }
+    BlockView<const T> colRange(int c0, int c1) const { return block(0, c0, row, c1 - c0); }
+
+    // All but one row and/or one column (pass -1 to keep every row or every column)
+    MinorView<T> minorView(int rowToExclude, int colToExclude) {
+        checkMinor(rowToExclude, colToExclude);
+        return MinorView<T>(mtx.data(), ld, row, col, rowToExclude, colToExclude);
+    }
+    MinorView<const T> minorView(int rowToExclude, int colToExclude) const {
+        checkMinor(rowToExclude, colToExclude);
+        return MinorView<const T>(mtx.data(), ld, row, col, rowToExclude, colToExclude);
+    }
+
+    // Copies every element into nested vectors; prefer rowView()/dataView() for reading
+    vector<vector<T>> getMatrix() const {
+        vector<vector<T>> nested(row, vector<T>(col));
+        for (int i = 0; i < row; i++) {
+            copy(mtx.begin() + index(i, 0), mtx.begin() + index(i, 0) + col, nested[i].begin());
+        }
+        return nested;
+    }
+
+    // The minor and its LU factors behind each cofactor are scratch matrices: they come from an arena
+    // (the calling thread's scratch arena unless one is passed) and are freed in one step by rewinding it.
+    BasicMatrix getCofMatrix() const {
+	return getCofMatrix(scratchArena());
+    }
 
-    Matrix getCofMatrix() const {
+    BasicMatrix getCofMatrix(MatrixArena& scratch) const {
 	if (row != col) {
 		throw runtime_error("Cofactor matrix can only be computed for square matrices!");
 	}
 
-	Matrix result(row, col); 
+	BasicMatrix result(row, col);
 
 	for (int i = 0; i < row; i++) {
 		for (int j = 0; j < col; j++) {
-			result.setElementAt(i, j, getCofactor(i, j));
+			const MatrixArena::Mark mark = scratch.mark();
+			{
+				ArenaScope scope(scratch);
+				result(i, j) = getCofactor(i, j);
+			}
+			scratch.rewind(mark);
 		}
 	}
 
 	return result;
     }
 
-    Matrix getSubMatrix(int rowToExclude, int colToExclude) const { 
-	    Matrix subMatrix(row - 1, col - 1);
-	    for (int i = 0, subRow = 0; i < row; i++) {
-	    	if (i == rowToExclude) continue;
-		    for (int j = 0, subCol = 0; j < col; j++) {
-			    if (j == colToExclude) continue;
-			    subMatrix.mtx[subRow][subCol++] = mtx[i][j];
-		    }
-		subRow++;
-	    }
-	return subMatrix;
-    } 
+    // Copy of minorView(rowToExclude, colToExclude)
+    BasicMatrix getSubMatrix(int rowToExclude, int colToExclude) const {
+	return BasicMatrix(minorView(rowToExclude, colToExclude));
+    }
 
-    long double getMinor(int rowToExclude, int colToExclude) const {
+    T getMinor(int rowToExclude, int colToExclude) const {
 	return det(getSubMatrix(rowToExclude, colToExclude));
     }
 
-    long double getCofactor(int rowToExclude, int colToExclude) const { 
+    T getCofactor(int rowToExclude, int colToExclude) const {
 	return ((rowToExclude + colToExclude) % 2 == 0 ? 1 : -1) * getMinor(rowToExclude, colToExclude);
     }
 
-    Matrix getinverse() const {
-	    if (det(*this)==0) {
-		    throw runtime_error("Matrix is not invertible!");
-	    }
-	    Matrix cofactorMatrix = this->getCofMatrix().transpose();
-	    long double deter = det(*this); 
-	    Matrix result(row, col);
-	    for (int i = 0; i < row; ++i) {
-		    for (int j = 0; j < col; ++j) {
-		    	result.setElementAt(i, j, cofactorMatrix.getMatrix()[i][j] / static_cast<long double>(deter));
-		    }
-	    }
-	return result;
+    // Inverse from one pivoted LU factorization: O(n^3) work in a single n x n buffer
+    BasicMatrix getinverse() const {
+	    return lu().inverse();
     }
 
     void inverse(){
-        Matrix temp = this->getinverse();
-        for(int i=0;i<row;i++){
-            for(int j=0;j<col;j++){
-                mtx[i][j] = temp.getElementAt(i,j);
-            }
-        }
-
+        *this = getinverse();
     }
-    
-    friend void printMatrix(const Matrix& mat);
-    friend long double det(const Matrix& mat);
+
+    friend void printMatrix<>(const BasicMatrix& mat);
+    friend T det<>(const BasicMatrix& mat);
 
         // Destructor
-    ~Matrix() = default;
+    ~BasicMatrix() = default;
 
 
 private:
     // Member variables
-    vector<vector<long double>> mtx;  // Renamed for clarity 
     int row, col;              // Renamed for clarity
+    int ld;                    // Row stride: col plus any spare column capacity
+    using Storage = vector<T, ArenaAllocator<T>>;
+    Storage mtx;               // Row-major, row * ld elements
+
+    size_t index(int i, int j) const { return static_cast<size_t>(i) * ld + j; }
+
+    // This matrix's elements in a fresh buffer with row stride newLd (>= col) and room for rowCapacity rows
+    Storage relaidOut(int newLd, size_t rowCapacity) const {
+        Storage out(mtx.get_allocator());
+        out.reserve(rowCapacity * newLd);
+        out.resize(static_cast<size_t>(row) * newLd);
+        for (int i = 0; i < row; i++) {
+            copy(mtx.begin() + index(i, 0), mtx.begin() + index(i, 0) + col, out.begin() + static_cast<size_t>(i) * newLd);
+        }
+        return out;
+    }
+
+    // dst(r0 + i, c0 + j) = b(i, j) in a buffer with row stride stride, rows split across threads
+    template <class E>
+    static void writeBlock(T* dst, size_t stride, int r0, int c0, const E& b) {
+        const int c = b.getCol();
+        parallelFor(0, b.getRow(), c, [&b, dst, stride, r0, c0, c](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; i++) {
+                T* d = dst + (r0 + i) * stride + c0;
+                for (int j = 0; j < c; j++) {
+                    d[j] = b(static_cast<int>(i), j);
+                }
+            }
+        });
+    }
+
+    // Writes the row * col elements without the spare columns to dst
+    void copyPacked(T* dst) const {
+        for (int i = 0; i < row; i++) {
+            copy(mtx.begin() + index(i, 0), mtx.begin() + index(i, 0) + col, dst + static_cast<size_t>(i) * col);
+        }
+    }
+
+    void checkBlock(int r0, int c0, int rows, int cols) const {
+        if (r0 < 0 || c0 < 0 || rows < 0 || cols < 0 || r0 + rows > row || c0 + cols > col) {
+            throw runtime_error("Index out of bounds!");
+        }
+    }
+
+    void checkMinor(int rowToExclude, int colToExclude) const {
+        if (rowToExclude < -1 || rowToExclude >= row || colToExclude < -1 || colToExclude >= col) {
+            throw runtime_error("Index out of bounds!");
+        }
+    }
+
+    // What evaluate() writes, for the aliasing checks of the expression nodes
+    AssignTarget assignTarget() const {
+        const char* lo = reinterpret_cast<const char*>(mtx.data());
+        return {mtx.data(), static_cast<size_t>(ld), lo, lo + mtx.size() * sizeof(T)};
+    }
+
+    // The fused loop behind every expression: one pass, rows split across threads,
+    // and a contiguous inner loop the compiler can vectorize.
+    template <class E>
+    void evaluate(const E& e) {
+        T* dst = mtx.data();
+        const int c = col;
+        const size_t stride = ld;
+        parallelFor(0, row, col, [&e, dst, c, stride](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; i++) {
+                T* d = dst + i * stride;
+                for (int j = 0; j < c; j++) {
+                    d[j] = e(static_cast<int>(i), j);
+                }
+            }
+        });
+    }
+};
+
+// The original long double matrix plus the vectorizable single/double precision variants
+using Matrix  = BasicMatrix<long double>;
+using MatrixD = BasicMatrix<double>;
+using MatrixF = BasicMatrix<float>;
+
+// LU decomposition with partial pivoting: P * A = L * U.
+// L (unit lower) and U are packed into one matrix; piv[k] is the row swapped into position k.
+template <class T>
+class LUDecomposition {
+public:
+    explicit LUDecomposition(const BasicMatrix<T>& a)
+        : lu(a), piv(a.getRow()), sign(1), singular(false), nearlySingular(false) {
+        if (a.getRow() != a.getCol()) {
+            throw invalid_argument("LU decomposition requires a square matrix.");
+        }
+        factorize();
+    }
+
+    int size() const { return lu.getRow(); }
+
+    // An exactly zero pivot: det == 0 and no inverse
+    bool isSingular() const { return singular; }
+
+    // Some pivot is at or below n * eps * max|a_ij|, so the factors (and det, inverse, solves) may have
+    // lost most of their digits. Badly scaled nonsingular matrices can trip this; it changes no result.
+    bool isNearlySingular() const { return singular || nearlySingular; }
+
+    T determinant() const {
+        if (singular) return T(0);
+        T d = static_cast<T>(sign);
+        for (int k = 0; k < size(); k++) {
+            d *= lu(k, k);
+        }
+        return d;
+    }
+
+    // A^-1 computed in place from the packed factors (LAPACK getri order):
+    // invert U, solve X * L = U^-1, then undo the row pivoting as column swaps.
+    BasicMatrix<T> inverse() const {
+        if (singular) {
+            throw runtime_error("Matrix is not invertible!");
+        }
+        const int n = size();
+        BasicMatrix<T> inv(lu);
+        T* a = inv.data();
+        vector<T> work(n);
+
+        // U^-1, bottom row first: row i = -(1/u_ii) * U(i, i+1:) * U^-1(i+1:, i+1:).
+        // Each row is a vector-matrix product, split across threads by column range.
+        for (int i = n - 1; i >= 0; i--) {
+            T* ri = a + static_cast<size_t>(i) * n;
+            const T d = T(1) / ri[i];
+            T* w = work.data();
+            parallelFor(i + 1, n, n - i, [=](size_t lo, size_t hi) {
+                fill(w + lo, w + hi, T(0));
+                for (int k = i + 1; k < n; k++) {
+                    const T c = ri[k];
+                    const T* rk = a + static_cast<size_t>(k) * n;
+                    for (size_t j = max<size_t>(lo, k); j < hi; j++) {
+                        w[j] += c * rk[j];
+                    }
+                }
+            });
+            ri[i] = d;
+            for (int j = i + 1; j < n; j++) {
+                ri[j] = -d * w[j];
+            }
+        }
+
+        // X * L = U^-1, one column at a time from the right; each step is a contiguous row dot product
+        for (int j = n - 2; j >= 0; j--) {
+            for (int k = j + 1; k < n; k++) {
+                T& l = a[static_cast<size_t>(k) * n + j];
+                work[k] = l;
+                l = 0;
+            }
+            const T* w = work.data();
+            parallelFor(0, n, n - j, [=](size_t lo, size_t hi) {
+                for (size_t i = lo; i < hi; i++) {
+                    T* ri = a + i * n;
+                    T sum = 0;
+                    for (int k = j + 1; k < n; k++) {
+                        sum += ri[k] * w[k];
+                    }
+                    ri[j] -= sum;
+                }
+            });
+        }
+
+        const vector<int>& pv = piv;
+        parallelFor(0, n, n, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; i++) {
+                T* ri = a + i * n;
+                for (int j = n - 2; j >= 0; j--) {
+                    if (pv[j] != j) swap(ri[j], ri[pv[j]]);
+                }
+            }
+        });
+        return inv;
+    }
+
+    // X = A^-1 * B for all columns of B at once: permute the rows of B, then forward and back
+    // substitution with the packed factors. The O(n^3) factorization is paid once in lu();
+    // each solve costs O(n^2) per right-hand side and is mostly GEMM when B is wide.
+    BasicMatrix<T> solve(const BasicMatrix<T>& B) const {
+        BasicMatrix<T> X(B);
+        solveInPlace(X);
+        return X;
+    }
+
+    vector<T> solve(const vector<T>& b) const {
+        BasicMatrix<T> x(static_cast<int>(b.size()), 1);
+        copy(b.begin(), b.end(), x.data());
+        solveInPlace(x);
+        return vector<T>(x.data(), x.data() + b.size());
+    }
+
+    // Overwrites B with the solution, so a hot loop can reuse one right-hand side buffer
+    void solveInPlace(BasicMatrix<T>& B) const {
+        solveInPlace(B.block(0, 0, B.getRow(), B.getCol()));
+    }
+
+    // Same, for right-hand sides that are a block of a larger matrix
+    void solveInPlace(const BlockView<T>& B) const {
+        if (B.getRow() != size()) {
+            throw runtime_error("Matrix dimensions do not match for solve!");
+        }
+        if (singular) {
+            throw runtime_error("Matrix is not invertible!");
+        }
+        const int n = size();
+        const int nrhs = B.getCol();
+        T* b = B.p;
+        for (int k = 0; k < n; k++) {
+            if (piv[k] != k) {
+                swap_ranges(b + k * B.ld, b + k * B.ld + nrhs, b + piv[k] * B.ld);
+            }
+        }
+        trsm<T>(true, true, n, nrhs, lu.data(), n, 1, b, B.ld);
+        trsm<T>(false, false, n, nrhs, lu.data(), n, 1, b, B.ld);
+    }
+
+    const BasicMatrix<T>& getPacked() const { return lu; }
+    const vector<int>& getPivots() const { return piv; }
+
+    BasicMatrix<T> getL() const {
+        const int n = size();
+        BasicMatrix<T> L(n, n);
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < i; j++) {
+                L(i, j) = lu(i, j);
+            }
+            L(i, i) = 1;
+        }
+        return L;
+    }
+
+    BasicMatrix<T> getU() const {
+        const int n = size();
+        BasicMatrix<T> U(n, n);
+        for (int i = 0; i < n; i++) {
+            for (int j = i; j < n; j++) {
+                U(i, j) = lu(i, j);
+            }
+        }
+        return U;
+    }
+
+private:
+    BasicMatrix<T> lu;
+    vector<int> piv;
+    int sign;
+    bool singular;
+    bool nearlySingular;
+
+    // Panel width of the blocked factorization; below 2 * lu_block the unblocked loop is used as is
+    static constexpr int lu_block = 64;
+
+    // Right-looking blocked LU: factor a panel of lu_block columns with partial pivoting,
+    // solve for the U block to its right, then update the trailing matrix with one GEMM.
+    // The GEMM and the triangular solve run on the thread pool.
+    void factorize() {
+        const int n = size();
+        T* a = lu.data();
+
+        T maxAbs = 0;
+        for (size_t k = 0; k < static_cast<size_t>(n) * n; k++) {
+            maxAbs = max(maxAbs, static_cast<T>(fabs(a[k])));
+        }
+        const T tol = numeric_limits<T>::epsilon() * n * maxAbs;
+
+        const int nb = n < 2 * lu_block ? n : lu_block;
+        for (int k0 = 0; k0 < n; k0 += nb) {
+            const int kend = min(n, k0 + nb);
+            factorPanel(k0, kend, tol);
+            if (kend == n) break;
+
+            // U12 = L11^-1 * A12 (unit lower forward substitution, independent per column range)
+            const int rest = n - kend;
+            parallelFor(0, rest, static_cast<size_t>(kend - k0) * (kend - k0), [=](size_t lo, size_t hi) {
+                for (int i = k0 + 1; i < kend; i++) {
+                    T* ri = a + static_cast<size_t>(i) * n + kend;
+                    for (int p = k0; p < i; p++) {
+                        const T l = a[static_cast<size_t>(i) * n + p];
+                        if (l == 0) continue;
+                        const T* rp = a + static_cast<size_t>(p) * n + kend;
+                        for (size_t j = lo; j < hi; j++) ri[j] -= l * rp[j];
+                    }
+                }
+            });
+
+            // A22 -= L21 * U12
+            gemm<T>(rest, rest, kend - k0, T(-1),
+                    a + static_cast<size_t>(kend) * n + k0, n, 1,
+                    a + static_cast<size_t>(k0) * n + kend, n, 1,
+                    T(1), a + static_cast<size_t>(kend) * n + kend, n);
+        }
+    }
+
+    // Unblocked partial-pivoting elimination of columns [k0, kend), updating only those columns.
+    // Row swaps move whole rows, which also applies the pivoting to L already formed and to A12/A22.
+    void factorPanel(int k0, int kend, T tol) {
+        const int n = size();
+        T* a = lu.data();
+        for (int k = k0; k < kend; k++) {
+            // Partial pivoting: bring the largest remaining entry of column k onto the diagonal
+            int p = k;
+            T best = fabs(a[static_cast<size_t>(k) * n + k]);
+            for (int i = k + 1; i < n; i++) {
+                T v = fabs(a[static_cast<size_t>(i) * n + k]);
+                if (v > best) {
+                    best = v;
+                    p = i;
+                }
+            }
+            piv[k] = p;
+            if (p != k) {
+                swap_ranges(a + static_cast<size_t>(k) * n, a + static_cast<size_t>(k + 1) * n, a + static_cast<size_t>(p) * n);
+                sign = -sign;
+            }
+
+            if (best <= tol) nearlySingular = true;
+            if (best == 0) {
+                // Zero multipliers keep the (exactly singular) factors consistent for the blocked update
+                singular = true;
+                for (int i = k + 1; i < n; i++) a[static_cast<size_t>(i) * n + k] = 0;
+                continue;
+            }
+
+            // Rank-1 update of the panel, row by row so the inner loop is contiguous
+            const T* pivotRow = a + static_cast<size_t>(k) * n;
+            const T inv = T(1) / pivotRow[k];
+            parallelFor(k + 1, n, kend - k, [=](size_t lo, size_t hi) {
+                for (size_t i = lo; i < hi; i++) {
+                    T* r = a + i * n;
+                    const T m = r[k] * inv;
+                    r[k] = m;
+                    if (m == 0) continue;
+                    for (int j = k + 1; j < kend; j++) {
+                        r[j] -= m * pivotRow[j];
+                    }
+                }
+            });
+        }
+    }
 };
 
-long double det(const Matrix& mat) {
-    return mat.determinantRecursive(mat.getMatrix());
+template <class T>
+T det(const BasicMatrix<T>& mat) {
+    return mat.lu().determinant();
 }
 
-void printMatrix(const Matrix& mat){
-    
-    for (const auto& row : mat.getMatrix()) {    
-        for (const auto& elem : row) {
-            cout << elem << " ";
+template <class T>
+void printMatrix(const BasicMatrix<T>& mat){
+
+    for (int i = 0; i < mat.row; i++) {
+        for (int j = 0; j < mat.col; j++) {
+            cout << mat.mtx[mat.index(i, j)] << " ";
         }
         cout << endl;
     }
@@ -0,0 +1,434 @@
+#ifndef MATRIXEXPR_H
+#define MATRIXEXPR_H
+
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <cstddef>
+#include "Gemm.h"
+
+using namespace std;
+
+template <class T> class BasicMatrix;
+
+// Lazy element-wise Matrix arithmetic. A + B * 2.0 builds a small tree of expression nodes
+// instead of temporaries; assigning it to a Matrix evaluates the whole tree in one fused,
+// vectorizable pass over the destination. Nodes refer to their Matrix operands, so an
+// expression must be evaluated before the matrices it mentions go away (don't store it in auto).
+
+// CRTP base of everything that can appear in an element-wise expression.
+// E provides value_type, getRow(), getCol() and operator()(i, j).
+template <class E>
+struct MatrixExpr {
+    const E& self() const { return static_cast<const E&>(*this); }
+
+    // Materialize the expression, e.g. (A + B).eval().print()
+    auto eval() const { return BasicMatrix<typename E::value_type>(*this); }
+};
+
+// The storage an element-wise assignment writes: element (i, j) goes to p + i * ld + j, and every
+// write lands within the bytes [begin, end). p is null when (i, j) is not written at that address.
+struct AssignTarget {
+    const void* p;
+    size_t ld;
+    const char* begin;
+    const char* end;
+};
+
+// True if rows x cols elements at p with row stride ld share any byte with the target's storage
+template <class T>
+bool overlapsTarget(const T* p, size_t ld, int rows, int cols, const AssignTarget& t) {
+    if (rows <= 0 || cols <= 0) return false;
+    const char* lo = reinterpret_cast<const char*>(p);
+    const char* hi = reinterpret_cast<const char*>(p + (rows - 1) * ld + cols);
+    return lo < t.end && t.begin < hi;
+}
+
+// Every node answers aliases(t): whether evaluating it while writing t element by element would read
+// an element of t at another (i, j) than the one being written, i.e. after it may have been overwritten.
+// Reading exactly the element being written (A = A + B) is not aliasing.
+
+// A Matrix operand inside an expression: the buffer pointer, row stride and shape
+template <class T>
+struct MatrixLeaf : MatrixExpr<MatrixLeaf<T>> {
+    using value_type = T;
+
+    const T* p;
+    size_t ld;
+    int rows, cols;
+
+    explicit MatrixLeaf(const BasicMatrix<T>& m) : p(m.data()), ld(m.getLd()), rows(m.getRow()), cols(m.getCol()) {}
+
+    int getRow() const { return rows; }
+    int getCol() const { return cols; }
+    T operator()(int i, int j) const { return p[i * ld + j]; }
+    bool aliases(const AssignTarget& t) const { return overlapsTarget(p, ld, rows, cols, t) && !(p == t.p && ld == t.ld); }
+};
+
+// Transpose of a Matrix that is never materialized: element (i, j) reads m(j, i)
+template <class T>
+struct TransposedView : MatrixExpr<TransposedView<T>> {
+    using value_type = T;
+
+    const T* p;
+    size_t ld;
+    int rows, cols;
+
+    explicit TransposedView(const BasicMatrix<T>& m) : p(m.data()), ld(m.getLd()), rows(m.getCol()), cols(m.getRow()) {}
+
+    int getRow() const { return rows; }
+    int getCol() const { return cols; }
+    T operator()(int i, int j) const { return p[j * ld + i]; }
+    bool aliases(const AssignTarget& t) const { return overlapsTarget(p, ld, cols, rows, t); }
+};
+
+// Matrices enter expressions as leaves; expression nodes are stored by value
+template <class E>
+struct ExprOperand {
+    using type = E;
+    static const E& wrap(const E& e) { return e; }
+};
+
+template <class T>
+struct ExprOperand<BasicMatrix<T>> {
+    using type = MatrixLeaf<T>;
+    static MatrixLeaf<T> wrap(const BasicMatrix<T>& m) { return MatrixLeaf<T>(m); }
+};
+
+template <class E>
+using expr_operand_t = typename ExprOperand<E>::type;
+
+template <class E>
+expr_operand_t<E> wrapOperand(const MatrixExpr<E>& e) { return ExprOperand<E>::wrap(e.self()); }
+
+struct AddOp { template <class T> static T apply(T a, T b) { return a + b; } };
+struct SubOp { template <class T> static T apply(T a, T b) { return a - b; } };
+struct MulOp { template <class T> static T apply(T a, T b) { return a * b; } };
+struct DivOp { template <class T> static T apply(T a, T b) { return a / b; } };
+
+// Element-wise combination of two same-shaped expressions
+template <class Op, class L, class R>
+struct BinaryExpr : MatrixExpr<BinaryExpr<Op, L, R>> {
+    using value_type = typename L::value_type;
+    static_assert(is_same<value_type, typename R::value_type>::value, "Matrix expressions must share an element type.");
+
+    L l;
+    R r;
+
+    BinaryExpr(const L& lhs, const R& rhs, const char* what) : l(lhs), r(rhs) {
+        if (l.getRow() != r.getRow() || l.getCol() != r.getCol()) {
+            throw runtime_error(string("Matrix dimensions do not match for ") + what + "!");
+        }
+    }
+
+    int getRow() const { return l.getRow(); }
+    int getCol() const { return l.getCol(); }
+    value_type operator()(int i, int j) const { return Op::apply(l(i, j), r(i, j)); }
+    bool aliases(const AssignTarget& t) const { return l.aliases(t) || r.aliases(t); }
+};
+
+// Expression combined with a scalar on the right (A * s, A / s, A + s, A - s)
+template <class Op, class E>
+struct ScalarExpr : MatrixExpr<ScalarExpr<Op, E>> {
+    using value_type = typename E::value_type;
+
+    E e;
+    value_type s;
+
+    ScalarExpr(const E& expr, value_type scalar) : e(expr), s(scalar) {}
+
+    int getRow() const { return e.getRow(); }
+    int getCol() const { return e.getCol(); }
+    value_type operator()(int i, int j) const { return Op::apply(e(i, j), s); }
+    bool aliases(const AssignTarget& t) const { return e.aliases(t); }
+};
+
+template <class E>
+struct NegateExpr : MatrixExpr<NegateExpr<E>> {
+    using value_type = typename E::value_type;
+
+    E e;
+
+    explicit NegateExpr(const E& expr) : e(expr) {}
+
+    int getRow() const { return e.getRow(); }
+    int getCol() const { return e.getCol(); }
+    value_type operator()(int i, int j) const { return -e(i, j); }
+    bool aliases(const AssignTarget& t) const { return e.aliases(t); }
+};
+
+// Writes e into the view v element by element (dst = op(dst, e(i, j))), rows split across threads.
+// Every element is read and written at the same (i, j), so v = v + w is safe; a right-hand side that
+// reads the same storage at a different offset must be materialized first (WritableView does that).
+template <class V, class E, class Op>
+void assignThrough(const V& v, const E& e, Op op, const char* what) {
+    if (v.getRow() != e.getRow() || v.getCol() != e.getCol()) {
+        throw runtime_error(string("Matrix dimensions do not match for ") + what + "!");
+    }
+    const int c = v.getCol();
+    parallelFor(0, v.getRow(), c, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; i++) {
+            for (int j = 0; j < c; j++) {
+                auto& d = v(static_cast<int>(i), j);
+                d = op(d, e(static_cast<int>(i), j));
+            }
+        }
+    });
+}
+
+struct AssignOp { template <class T> static T apply(T, T b) { return b; } };
+
+// Assignment, +=, -= and scalar *= shared by the views below; writes go to the parent matrix
+template <class V, class T>
+struct WritableView : MatrixExpr<V> {
+    template <class E>
+    const V& operator=(const MatrixExpr<E>& e) const { return apply<AssignOp>(e, "assignment"); }
+    template <class E>
+    const V& operator+=(const MatrixExpr<E>& e) const { return apply<AddOp>(e, "addition"); }
+    template <class E>
+    const V& operator-=(const MatrixExpr<E>& e) const { return apply<SubOp>(e, "subtraction"); }
+    const V& operator*=(T s) const {
+        const V& v = static_cast<const V&>(*this);
+        assignThrough(v, v, [s](T a, T) { return a * s; }, "multiplication");
+        return v;
+    }
+
+    // Every element of the view set to s
+    const V& fill(T s) const {
+        const V& v = static_cast<const V&>(*this);
+        assignThrough(v, v, [s](T, T) { return s; }, "assignment");
+        return v;
+    }
+
+private:
+    template <class Op, class E>
+    const V& apply(const MatrixExpr<E>& e, const char* what) const {
+        const V& v = static_cast<const V&>(*this);
+        const auto op = [](T a, T b) { return Op::apply(a, b); };
+        const auto rhs = wrapOperand(e);
+        if (rhs.aliases(v.assignTarget())) {
+            // e.g. a block assigned its own transpose: read everything before anything is written
+            const BasicMatrix<T> copy = e.eval();
+            assignThrough(v, MatrixLeaf<T>(copy), op, what);
+        } else {
+            assignThrough(v, rhs, op, what);
+        }
+        return v;
+    }
+};
+
+// Rectangular block of a Matrix used in place: rows x cols elements with row stride ld.
+// Reads and writes go straight to the parent, which must outlive the view and not be resized.
+// BlockView<const T> is the read-only form handed out by const matrices.
+template <class T>
+struct BlockView : WritableView<BlockView<T>, typename remove_const<T>::type> {
+    using value_type = typename remove_const<T>::type;
+    using WritableView<BlockView<T>, value_type>::operator=;
+
+    T* p;
+    size_t ld;
+    int rows, cols;
+
+    BlockView(T* data, size_t stride, int r, int c) : p(data), ld(stride), rows(r), cols(c) {}
+    BlockView(const BlockView&) = default;
+
+    // A writable view converts to a read-only one
+    template <class U, class = typename enable_if<is_same<const U, T>::value && !is_same<U, T>::value>::type>
+    BlockView(const BlockView<U>& other) : p(other.p), ld(other.ld), rows(other.rows), cols(other.cols) {}
+
+    // Copies elements (like the other assignments), it does not re-point the view
+    const BlockView& operator=(const BlockView& other) const { return *this = static_cast<const MatrixExpr<BlockView>&>(other); }
+
+    int getRow() const { return rows; }
+    int getCol() const { return cols; }
+    T& operator()(int i, int j) const { return p[i * ld + j]; }
+    bool aliases(const AssignTarget& t) const { return overlapsTarget(p, ld, rows, cols, t) && !(p == t.p && ld == t.ld); }
+    AssignTarget assignTarget() const {
+        const char* lo = reinterpret_cast<const char*>(p);
+        return {p, ld, lo, rows > 0 && cols > 0 ? reinterpret_cast<const char*>(p + (rows - 1) * ld + cols) : lo};
+    }
+
+    // Sub-block of this block, still pointing into the parent
+    BlockView block(int r0, int c0, int r, int c) const {
+        if (r0 < 0 || c0 < 0 || r < 0 || c < 0 || r0 + r > rows || c0 + c > cols) {
+            throw runtime_error("Index out of bounds!");
+        }
+        return BlockView(p + r0 * ld + c0, ld, r, c);
+    }
+};
+
+// The matrix without one row and/or one column (-1 keeps them all), used in place.
+// Not strided, so products materialize it once; element-wise expressions read it directly.
+template <class T>
+struct MinorView : WritableView<MinorView<T>, typename remove_const<T>::type> {
+    using value_type = typename remove_const<T>::type;
+    using WritableView<MinorView<T>, value_type>::operator=;
+
+    T* p;
+    size_t ld;
+    int rows, cols;
+    int skipRow, skipCol;
+
+    MinorView(T* data, size_t stride, int parentRows, int parentCols, int rowToExclude, int colToExclude)
+        : p(data), ld(stride),
+          rows(parentRows - (rowToExclude >= 0)), cols(parentCols - (colToExclude >= 0)),
+          skipRow(rowToExclude >= 0 ? rowToExclude : parentRows), skipCol(colToExclude >= 0 ? colToExclude : parentCols) {}
+    MinorView(const MinorView&) = default;
+
+    const MinorView& operator=(const MinorView& other) const { return *this = static_cast<const MatrixExpr<MinorView>&>(other); }
+
+    int getRow() const { return rows; }
+    int getCol() const { return cols; }
+    T& operator()(int i, int j) const { return p[(i + (i >= skipRow)) * ld + j + (j >= skipCol)]; }
+
+    // Only rows and columns before the skipped ones sit where a plain rows x cols block would
+    bool shifted() const { return skipRow < rows || skipCol < cols; }
+    bool aliases(const AssignTarget& t) const {
+        return overlapsTarget(p, ld, rows + (skipRow < rows), cols + (skipCol < cols), t) && (shifted() || !(p == t.p && ld == t.ld));
+    }
+    AssignTarget assignTarget() const {
+        const int r = rows + (skipRow < rows), c = cols + (skipCol < cols);
+        const char* lo = reinterpret_cast<const char*>(p);
+        return {shifted() ? nullptr : p, ld, lo, r > 0 && c > 0 ? reinterpret_cast<const char*>(p + (r - 1) * ld + c) : lo};
+    }
+};
+
+// The elements of an expression converted to another type, e.g. a long double Matrix read as doubles
+template <class U, class E>
+struct CastExpr : MatrixExpr<CastExpr<U, E>> {
+    using value_type = U;
+
+    E e;
+
+    explicit CastExpr(const E& expr) : e(expr) {}
+
+    int getRow() const { return e.getRow(); }
+    int getCol() const { return e.getCol(); }
+    value_type operator()(int i, int j) const { return static_cast<U>(e(i, j)); }
+    bool aliases(const AssignTarget& t) const { return e.aliases(t); }
+};
+
+template <class L, class R>
+BinaryExpr<AddOp, expr_operand_t<L>, expr_operand_t<R>> operator+(const MatrixExpr<L>& l, const MatrixExpr<R>& r) {
+    return {wrapOperand(l), wrapOperand(r), "addition"};
+}
+
+template <class L, class R>
+BinaryExpr<SubOp, expr_operand_t<L>, expr_operand_t<R>> operator-(const MatrixExpr<L>& l, const MatrixExpr<R>& r) {
+    return {wrapOperand(l), wrapOperand(r), "subtraction"};
+}
+
+template <class E>
+NegateExpr<expr_operand_t<E>> operator-(const MatrixExpr<E>& e) {
+    return NegateExpr<expr_operand_t<E>>(wrapOperand(e));
+}
+
+template <class E>
+ScalarExpr<AddOp, expr_operand_t<E>> operator+(const MatrixExpr<E>& e, typename E::value_type s) {
+    return {wrapOperand(e), s};
+}
+
+template <class E>
+ScalarExpr<AddOp, expr_operand_t<E>> operator+(typename E::value_type s, const MatrixExpr<E>& e) {
+    return {wrapOperand(e), s};
+}
+
+template <class E>
+ScalarExpr<SubOp, expr_operand_t<E>> operator-(const MatrixExpr<E>& e, typename E::value_type s) {
+    return {wrapOperand(e), s};
+}
+
+template <class E>
+ScalarExpr<MulOp, expr_operand_t<E>> operator*(const MatrixExpr<E>& e, typename E::value_type s) {
+    return {wrapOperand(e), s};
+}
+
+template <class E>
+ScalarExpr<MulOp, expr_operand_t<E>> operator*(typename E::value_type s, const MatrixExpr<E>& e) {
+    return {wrapOperand(e), s};
+}
+
+template <class E>
+ScalarExpr<DivOp, expr_operand_t<E>> operator/(const MatrixExpr<E>& e, typename E::value_type s) {
+    if (s == 0) {
+        throw runtime_error("Division by zero!");
+    }
+    return {wrapOperand(e), s};
+}
+
+// MatrixD Ad = elementCast<double>(A); converts in one fused pass like any other expression
+template <class U, class E>
+CastExpr<U, expr_operand_t<E>> elementCast(const MatrixExpr<E>& e) {
+    return CastExpr<U, expr_operand_t<E>>(wrapOperand(e));
+}
+
+// A product operand as GEMM sees it: element (i, j) is p[i * rs + j * cs]
+template <class T>
+struct StridedOperand {
+    const T* p;
+    ptrdiff_t rs, cs;
+    int rows, cols;
+};
+
+// Matrices and transposed views are used in place; other expressions are materialized once
+template <class T>
+const BasicMatrix<T>& productOperand(const BasicMatrix<T>& m) { return m; }
+
+template <class T>
+const TransposedView<T>& productOperand(const TransposedView<T>& v) { return v; }
+
+template <class T>
+const BlockView<T>& productOperand(const BlockView<T>& v) { return v; }
+
+template <class E>
+BasicMatrix<typename E::value_type> productOperand(const MatrixExpr<E>& e) { return e.eval(); }
+
+template <class T>
+StridedOperand<T> stridedOperand(const BasicMatrix<T>& m) {
+    return {m.data(), m.getLd(), 1, m.getRow(), m.getCol()};
+}
+
+template <class T>
+StridedOperand<T> stridedOperand(const TransposedView<T>& v) {
+    return {v.p, 1, static_cast<ptrdiff_t>(v.ld), v.rows, v.cols};
+}
+
+template <class T>
+StridedOperand<typename remove_const<T>::type> stridedOperand(const BlockView<T>& v) {
+    return {v.p, static_cast<ptrdiff_t>(v.ld), 1, v.rows, v.cols};
+}
+
+// Matrix product (not element-wise) through the blocked GEMM engine
+template <class L, class R>
+BasicMatrix<typename L::value_type> operator*(const MatrixExpr<L>& l, const MatrixExpr<R>& r) {
+    using T = typename L::value_type;
+    const auto& lhs = productOperand(l.self());
+    const auto& rhs = productOperand(r.self());
+    const StridedOperand<T> a = stridedOperand(lhs);
+    const StridedOperand<T> b = stridedOperand(rhs);
+    if (a.cols != b.rows) {
+        throw runtime_error("Matrix dimensions do not match for multiplication!");
+    }
+    BasicMatrix<T> result(a.rows, b.cols);
+    gemm<T>(a.rows, b.cols, a.cols, T(1), a.p, a.rs, a.cs, b.p, b.rs, b.cs, T(0), result.data(), result.getCol());
+    return result;
+}
+
+// C = alpha * A * B + beta * C written straight into a block of an existing matrix (no temporary).
+// C must not overlap A or B.
+template <class L, class R, class T>
+void multiply_into(const MatrixExpr<L>& l, const MatrixExpr<R>& r, const BlockView<T>& c,
+                   typename BlockView<T>::value_type alpha = 1, typename BlockView<T>::value_type beta = 0) {
+    using V = typename BlockView<T>::value_type;
+    static_assert(!is_const<T>::value, "multiply_into needs a writable destination.");
+    const auto& lhs = productOperand(l.self());
+    const auto& rhs = productOperand(r.self());
+    const StridedOperand<V> a = stridedOperand(lhs);
+    const StridedOperand<V> b = stridedOperand(rhs);
+    if (a.cols != b.rows || c.rows != a.rows || c.cols != b.cols) {
+        throw runtime_error("Matrix dimensions do not match for multiplication!");
+    }
+    gemm<V>(a.rows, b.cols, a.cols, alpha, a.p, a.rs, a.cs, b.p, b.rs, b.cs, beta, c.p, c.ld);
+}
+
+#endif  // MATRIXEXPR_H
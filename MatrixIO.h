@@ -0,0 +1,424 @@
+#ifndef MATRIXIO_H
+#define MATRIXIO_H
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "Matrix.h"
+
+using namespace std;
+
+// Binary matrix files: a 64-byte header followed by rows * cols elements, row-major, in the
+// producer's native byte order. The header pads the data to a 64-byte offset, so a mapped file
+// can be used in place (see MappedMatrix) and bulk loads are one read straight into the buffer.
+
+enum class MatrixDType : uint8_t { Float = 1, Double = 2, LongDouble = 3 };
+
+struct MatrixFileHeader {
+    char magic[4];       // "CMAT"
+    uint16_t version;
+    uint8_t dtype;       // MatrixDType
+    uint8_t elemSize;    // bytes per element; long double differs between platforms
+    uint32_t byteOrder;  // matrixFileByteOrder as the producer stored it
+    uint32_t reserved;
+    uint64_t rows;
+    uint64_t cols;
+    uint8_t padding[32];
+};
+static_assert(sizeof(MatrixFileHeader) == 64, "Matrix file header must be 64 bytes.");
+
+constexpr uint16_t matrixFileVersion = 1;
+constexpr uint32_t matrixFileByteOrder = 0x01020304;
+
+// Working set the out-of-core algorithms aim for unless told otherwise
+constexpr size_t outOfCoreBudget = size_t(256) << 20;
+
+namespace matrixio_detail {
+
+template <class T>
+constexpr MatrixDType dtypeOf() {
+    static_assert(is_same<T, float>::value || is_same<T, double>::value || is_same<T, long double>::value,
+                  "Matrix files hold float, double or long double elements.");
+    return is_same<T, float>::value ? MatrixDType::Float
+         : is_same<T, double>::value ? MatrixDType::Double : MatrixDType::LongDouble;
+}
+
+template <class T>
+MatrixFileHeader makeHeader(uint64_t rows, uint64_t cols) {
+    MatrixFileHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, "CMAT", 4);
+    h.version = matrixFileVersion;
+    h.dtype = static_cast<uint8_t>(dtypeOf<T>());
+    h.elemSize = sizeof(T);
+    h.byteOrder = matrixFileByteOrder;
+    h.rows = rows;
+    h.cols = cols;
+    return h;
+}
+
+inline void checkHeader(const MatrixFileHeader& h, const string& path) {
+    if (memcmp(h.magic, "CMAT", 4) != 0 || h.version != matrixFileVersion) {
+        throw runtime_error("Not a matrix file: " + path);
+    }
+    if (h.byteOrder != matrixFileByteOrder) {
+        throw runtime_error("Matrix file was written with a different byte order: " + path);
+    }
+    const bool known = (h.dtype == static_cast<uint8_t>(MatrixDType::Float) && h.elemSize == sizeof(float)) ||
+                       (h.dtype == static_cast<uint8_t>(MatrixDType::Double) && h.elemSize == sizeof(double)) ||
+                       (h.dtype == static_cast<uint8_t>(MatrixDType::LongDouble) && h.elemSize == sizeof(long double));
+    if (!known) {
+        throw runtime_error("Unsupported element type in matrix file: " + path);
+    }
+    if (h.rows == 0 || h.cols == 0 || h.rows > uint64_t(numeric_limits<int>::max()) ||
+        h.cols > uint64_t(numeric_limits<int>::max())) {
+        throw runtime_error("Invalid matrix dimensions in file: " + path);
+    }
+}
+
+// Converts n stored elements of the file's dtype into T
+template <class T>
+void convertFrom(MatrixDType dtype, const unsigned char* src, T* dst, size_t n) {
+    switch (dtype) {
+    case MatrixDType::Float:
+        for (size_t k = 0; k < n; k++) { float x; memcpy(&x, src + k * sizeof(float), sizeof(float)); dst[k] = static_cast<T>(x); }
+        break;
+    case MatrixDType::Double:
+        for (size_t k = 0; k < n; k++) { double x; memcpy(&x, src + k * sizeof(double), sizeof(double)); dst[k] = static_cast<T>(x); }
+        break;
+    case MatrixDType::LongDouble:
+        for (size_t k = 0; k < n; k++) { long double x; memcpy(&x, src + k * sizeof(long double), sizeof(long double)); dst[k] = static_cast<T>(x); }
+        break;
+    }
+}
+
+// Closes the FILE on every exit path
+struct FileCloser {
+    FILE* f;
+    ~FileCloser() { if (f) fclose(f); }
+};
+
+}  // namespace matrixio_detail
+
+// Writes m to path in the binary format (one header write, one bulk data write for packed matrices)
+template <class T>
+void saveMatrix(const BasicMatrix<T>& m, const string& path) {
+    using namespace matrixio_detail;
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) {
+        throw runtime_error("Cannot open file for writing: " + path);
+    }
+    FileCloser closer{f};
+    const MatrixFileHeader h = makeHeader<T>(m.getRow(), m.getCol());
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1;
+    if (m.getLd() == m.getCol()) {
+        const size_t n = static_cast<size_t>(m.getRow()) * m.getCol();
+        ok = ok && fwrite(m.data(), sizeof(T), n, f) == n;
+    } else {
+        // Spare column capacity is not part of the file
+        const size_t n = m.getCol();
+        for (int i = 0; ok && i < m.getRow(); i++) {
+            ok = fwrite(m.data() + static_cast<size_t>(i) * m.getLd(), sizeof(T), n, f) == n;
+        }
+    }
+    if (!ok || fflush(f) != 0) {
+        throw runtime_error("Cannot write matrix file: " + path);
+    }
+}
+
+// Reads a matrix file into memory. Files of the same element type are read straight into the
+// matrix; other element types are converted chunk by chunk.
+template <class T>
+BasicMatrix<T> loadMatrix(const string& path) {
+    using namespace matrixio_detail;
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) {
+        throw runtime_error("Cannot open file: " + path);
+    }
+    FileCloser closer{f};
+    MatrixFileHeader h;
+    if (fread(&h, sizeof(h), 1, f) != 1) {
+        throw runtime_error("Not a matrix file: " + path);
+    }
+    checkHeader(h, path);
+
+    BasicMatrix<T> m(static_cast<int>(h.rows), static_cast<int>(h.cols));
+    const size_t n = static_cast<size_t>(h.rows) * h.cols;
+    const MatrixDType dtype = static_cast<MatrixDType>(h.dtype);
+    if (dtype == dtypeOf<T>()) {
+        if (fread(m.data(), sizeof(T), n, f) != n) {
+            throw runtime_error("Matrix file is truncated: " + path);
+        }
+        return m;
+    }
+    const size_t chunk = size_t(1) << 16;
+    vector<unsigned char> buf(chunk * h.elemSize);
+    for (size_t k = 0; k < n; k += chunk) {
+        const size_t len = min(chunk, n - k);
+        if (fread(buf.data(), h.elemSize, len, f) != len) {
+            throw runtime_error("Matrix file is truncated: " + path);
+        }
+        convertFrom(dtype, buf.data(), m.data() + k, len);
+    }
+    return m;
+}
+
+// A matrix file mapped into memory: elements are paged in from disk when touched and written back
+// by the OS, so the matrix may be larger than RAM. Elements are used in place, hence the file's
+// element type must be T. Blocks are ordinary BlockViews, so expressions, products, solves and
+// BasicMatrix conversions work on any part of the mapping; multiplyOutOfCore and transposeOutOfCore
+// below bound how much of it is touched at once.
+template <class T>
+class MappedMatrix {
+public:
+    // Creates (or truncates) path as a zero rows x cols matrix file and maps it for writing.
+    // The data is allocated sparsely, so creating a huge file is immediate.
+    static MappedMatrix create(const string& path, int rows, int cols) {
+        if (rows <= 0 || cols <= 0) {
+            throw invalid_argument("Matrix dimensions must be positive integers.");
+        }
+        const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            throw runtime_error("Cannot open file for writing: " + path);
+        }
+        const MatrixFileHeader h = matrixio_detail::makeHeader<T>(rows, cols);
+        const size_t bytes = sizeof(h) + static_cast<size_t>(rows) * cols * sizeof(T);
+        if (ftruncate(fd, static_cast<off_t>(bytes)) != 0 ||
+            pwrite(fd, &h, sizeof(h), 0) != static_cast<ssize_t>(sizeof(h))) {
+            ::close(fd);
+            throw runtime_error("Cannot write matrix file: " + path);
+        }
+        return MappedMatrix(fd, bytes, rows, cols, true, path);
+    }
+
+    // Maps an existing matrix file. Unless writable is set the mapping is private: elements can
+    // still be modified in memory, but the changes never reach the file.
+    static MappedMatrix open(const string& path, bool writable = false) {
+        const int fd = ::open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+        if (fd < 0) {
+            throw runtime_error("Cannot open file: " + path);
+        }
+        MatrixFileHeader h;
+        struct stat st;
+        if (pread(fd, &h, sizeof(h), 0) != static_cast<ssize_t>(sizeof(h)) || fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw runtime_error("Not a matrix file: " + path);
+        }
+        try {
+            matrixio_detail::checkHeader(h, path);
+            if (h.dtype != static_cast<uint8_t>(matrixio_detail::dtypeOf<T>())) {
+                throw runtime_error("Matrix file element type does not match: " + path);
+            }
+        } catch (...) {
+            ::close(fd);
+            throw;
+        }
+        const size_t bytes = sizeof(h) + static_cast<size_t>(h.rows) * h.cols * sizeof(T);
+        if (static_cast<size_t>(st.st_size) < bytes) {
+            ::close(fd);
+            throw runtime_error("Matrix file is truncated: " + path);
+        }
+        return MappedMatrix(fd, bytes, static_cast<int>(h.rows), static_cast<int>(h.cols), writable, path);
+    }
+
+    MappedMatrix(const MappedMatrix&) = delete;
+    MappedMatrix& operator=(const MappedMatrix&) = delete;
+
+    MappedMatrix(MappedMatrix&& other) noexcept
+        : fd(other.fd), base(other.base), bytes(other.bytes), row(other.row), col(other.col), writable(other.writable) {
+        other.fd = -1;
+        other.base = nullptr;
+    }
+
+    MappedMatrix& operator=(MappedMatrix&& other) noexcept {
+        if (this != &other) {
+            release();
+            fd = other.fd; base = other.base; bytes = other.bytes;
+            row = other.row; col = other.col; writable = other.writable;
+            other.fd = -1;
+            other.base = nullptr;
+        }
+        return *this;
+    }
+
+    ~MappedMatrix() { release(); }
+
+    int getRow() const { return row; }
+    int getCol() const { return col; }
+    bool isWritable() const { return writable; }
+
+    T* data() { return elements(); }
+    const T* data() const { return elements(); }
+
+    // Unchecked element access for inner loops
+    T& operator()(int i, int j) { return elements()[static_cast<size_t>(i) * col + j]; }
+    const T& operator()(int i, int j) const { return elements()[static_cast<size_t>(i) * col + j]; }
+
+    BlockView<T> block(int r0, int c0, int rows, int cols) {
+        checkBlock(r0, c0, rows, cols);
+        return BlockView<T>(elements() + static_cast<size_t>(r0) * col + c0, col, rows, cols);
+    }
+    BlockView<const T> block(int r0, int c0, int rows, int cols) const {
+        checkBlock(r0, c0, rows, cols);
+        return BlockView<const T>(elements() + static_cast<size_t>(r0) * col + c0, col, rows, cols);
+    }
+
+    // Rows [r0, r1)
+    BlockView<T> rowRange(int r0, int r1) { return block(r0, 0, r1 - r0, col); }
+    BlockView<const T> rowRange(int r0, int r1) const { return block(r0, 0, r1 - r0, col); }
+
+    // Copies the whole matrix into memory
+    BasicMatrix<T> toMatrix() const { return BasicMatrix<T>(block(0, 0, row, col)); }
+
+    // Writes dirty pages back to the file now rather than whenever the OS chooses
+    void flush() {
+        if (writable && msync(base, bytes, MS_SYNC) != 0) {
+            throw runtime_error("Cannot write matrix file!");
+        }
+    }
+
+    // Paging hints for rows [r0, r1): read them ahead, or drop them from this process once done.
+    // Dropping a private page would discard changes made to it in memory, so a private mapping only
+    // marks the rows as cold (reclaimed first under memory pressure, contents kept).
+    void willNeed(int r0, int r1) const { advise(r0, r1, MADV_WILLNEED); }
+    void doneWith(int r0, int r1) const {
+        if (writable) {
+            advise(r0, r1, MADV_DONTNEED);
+        } else {
+#ifdef MADV_COLD
+            advise(r0, r1, MADV_COLD);
+#endif
+        }
+    }
+
+private:
+    int fd;
+    void* base;
+    size_t bytes;
+    int row, col;
+    bool writable;
+
+    MappedMatrix(int f, size_t size, int rows, int cols, bool canWrite, const string& path)
+        : fd(f), base(nullptr), bytes(size), row(rows), col(cols), writable(canWrite) {
+        base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, canWrite ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+        if (base == MAP_FAILED) {
+            base = nullptr;
+            release();
+            throw runtime_error("Cannot map matrix file: " + path);
+        }
+    }
+
+    T* elements() const {
+        return reinterpret_cast<T*>(static_cast<unsigned char*>(base) + sizeof(MatrixFileHeader));
+    }
+
+    void release() {
+        if (base) munmap(base, bytes);
+        if (fd >= 0) ::close(fd);
+        base = nullptr;
+        fd = -1;
+    }
+
+    void checkBlock(int r0, int c0, int rows, int cols) const {
+        if (r0 < 0 || c0 < 0 || rows < 0 || cols < 0 || r0 + rows > row || c0 + cols > col) {
+            throw runtime_error("Index out of bounds!");
+        }
+    }
+
+    // madvise needs page-aligned ranges: widen [r0, r1) to whole pages (WILLNEED) or shrink it to
+    // the pages it covers entirely (DONTNEED and COLD, so neighbouring rows are left alone)
+    void advise(int r0, int r1, int how) const {
+        if (r0 >= r1) return;
+        const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        const size_t lo = sizeof(MatrixFileHeader) + static_cast<size_t>(r0) * col * sizeof(T);
+        const size_t hi = sizeof(MatrixFileHeader) + static_cast<size_t>(r1) * col * sizeof(T);
+        size_t a = lo / page * page, b = (hi + page - 1) / page * page;
+        if (how != MADV_WILLNEED) {
+            a = (lo + page - 1) / page * page;
+            b = hi / page * page;
+        }
+        b = min(b, (bytes + page - 1) / page * page);
+        if (a < b) madvise(static_cast<unsigned char*>(base) + a, b - a, how);
+    }
+};
+
+// C = A * B for matrices too large to hold in memory together. C is produced one panel of rows at a
+// time, directly in the mapping: each panel accumulates the products of an A tile and a B row panel,
+// so the working set is the C panel, one A tile and one B panel, sized to fit memoryBytes, and B is
+// streamed once per C panel. Finished C panels are dropped from memory, so C must be mapped writable.
+template <class T>
+void multiplyOutOfCore(const MappedMatrix<T>& A, const MappedMatrix<T>& B, MappedMatrix<T>& C,
+                       size_t memoryBytes = outOfCoreBudget) {
+    if (A.getCol() != B.getRow() || C.getRow() != A.getRow() || C.getCol() != B.getCol()) {
+        throw runtime_error("Matrix dimensions do not match for multiplication!");
+    }
+    if (!C.isWritable()) {
+        throw invalid_argument("The product needs a writable mapping (create() or open(path, true)).");
+    }
+    const int m = A.getRow(), k = A.getCol(), n = B.getCol();
+    // Panel height t (also the k tile): t * n (C panel) + t * t (A tile) + t * n (B panel) elements fit
+    const double budget = static_cast<double>(memoryBytes / sizeof(T));
+    int t = static_cast<int>(sqrt(static_cast<double>(n) * n + budget) - n);
+    t = max(64, t / 64 * 64);
+    const T* a = A.data();
+    const T* b = B.data();
+    T* c = C.data();
+    for (int i0 = 0; i0 < m; i0 += t) {
+        const int mb = min(t, m - i0);
+        for (int k0 = 0; k0 < k; k0 += t) {
+            const int kb = min(t, k - k0);
+            if (k0 + kb < k) B.willNeed(k0 + kb, min(k, k0 + kb + t));
+            gemm<T>(mb, n, kb, T(1),
+                    a + static_cast<size_t>(i0) * k + k0, k, 1,
+                    b + static_cast<size_t>(k0) * n, n, 1,
+                    k0 == 0 ? T(0) : T(1), c + static_cast<size_t>(i0) * n, n);
+            B.doneWith(k0, k0 + kb);
+        }
+        A.doneWith(i0, i0 + mb);
+        C.doneWith(i0, i0 + mb);
+    }
+}
+
+// At = A^T through the mapping, one panel of A rows at a time: the panel is read sequentially and
+// lands as a column stripe of At, with the cache-oblivious tile kernel of BasicMatrix::transpose
+// splitting the stripe across threads. At must be mapped writable.
+template <class T>
+void transposeOutOfCore(const MappedMatrix<T>& A, MappedMatrix<T>& At, size_t memoryBytes = outOfCoreBudget) {
+    if (At.getRow() != A.getCol() || At.getCol() != A.getRow()) {
+        throw runtime_error("Matrix dimensions do not match for transpose!");
+    }
+    if (!At.isWritable()) {
+        throw invalid_argument("The transpose needs a writable mapping (create() or open(path, true)).");
+    }
+    const int r = A.getRow(), c = A.getCol();
+    // The A panel and the At stripe it lands in are the same size: half the budget each
+    const size_t perRow = 2 * static_cast<size_t>(c) * sizeof(T);
+    int panel = static_cast<int>(min<size_t>(r, max<size_t>(1, memoryBytes / perRow)));
+    panel = max(transposeTile, panel / transposeTile * transposeTile);
+    const T* a = A.data();
+    T* t = At.data();
+    for (int r0 = 0; r0 < r; r0 += panel) {
+        const int rows = min(panel, r - r0);
+        if (r0 + rows < r) A.willNeed(r0 + rows, min(r, r0 + rows + panel));
+        const T* src = a + static_cast<size_t>(r0) * c;
+        const int stripe = transposeTile * 2;
+        parallelFor(0, (c + stripe - 1) / stripe, static_cast<size_t>(stripe) * rows, [=](size_t lo, size_t hi) {
+            const int j0 = static_cast<int>(lo) * stripe;
+            const int j1 = min(c, static_cast<int>(hi) * stripe);
+            transposeBlock(src + j0, c, t + static_cast<size_t>(j0) * r + r0, r, rows, j1 - j0);
+        });
+        A.doneWith(r0, r0 + rows);
+    }
+}
+
+#endif  // MATRIXIO_H
@@ -0,0 +1,154 @@
+#ifndef SMALLVECTOR_H
+#define SMALLVECTOR_H
+
+#include <vector>
+#include <initializer_list>
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include <cstddef>
+
+using namespace std;
+
+// Vector that keeps up to N elements inline and moves to the heap only beyond that. Tensor shapes
+// and strides use it, so creating, copying and moving tensors of up to N dimensions allocates nothing
+// for metadata. Elements must be trivially copyable; it converts implicitly from std::vector and
+// braced lists, so code that passes shapes as vector<size_t> or {2, 3} keeps working.
+template <class T, size_t N>
+class SmallVector {
+    static_assert(is_trivially_copyable<T>::value, "SmallVector elements must be trivially copyable.");
+
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    SmallVector() noexcept : ptr(local), count(0), cap(N) {}
+    SmallVector(size_t n, const T& v) : SmallVector() { assign(n, v); }
+    SmallVector(initializer_list<T> list) : SmallVector() { assign(list.begin(), list.end()); }
+    template <class It, class = enable_if_t<!is_integral<It>::value>>
+    SmallVector(It first, It last) : SmallVector() { assign(first, last); }
+    SmallVector(const vector<T>& v) : SmallVector() { assign(v.begin(), v.end()); }
+
+    SmallVector(const SmallVector& other) : SmallVector() { assign(other.begin(), other.end()); }
+    SmallVector(SmallVector&& other) noexcept : SmallVector() { take(other); }
+
+    SmallVector& operator=(const SmallVector& other) {
+        if (this != &other) assign(other.begin(), other.end());
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& other) noexcept {
+        if (this != &other) {
+            release();
+            take(other);
+        }
+        return *this;
+    }
+
+    ~SmallVector() { release(); }
+
+    // For callers that keep shapes in a std::vector
+    operator vector<T>() const { return vector<T>(begin(), end()); }
+
+    size_t size() const noexcept { return count; }
+    bool empty() const noexcept { return count == 0; }
+    size_t capacity() const noexcept { return cap; }
+    // True while the elements live in the inline buffer
+    bool is_inline() const noexcept { return ptr == local; }
+
+    T* data() noexcept { return ptr; }
+    const T* data() const noexcept { return ptr; }
+    T& operator[](size_t i) noexcept { return ptr[i]; }
+    const T& operator[](size_t i) const noexcept { return ptr[i]; }
+    T& back() noexcept { return ptr[count - 1]; }
+    const T& back() const noexcept { return ptr[count - 1]; }
+
+    iterator begin() noexcept { return ptr; }
+    iterator end() noexcept { return ptr + count; }
+    const_iterator begin() const noexcept { return ptr; }
+    const_iterator end() const noexcept { return ptr + count; }
+
+    void reserve(size_t n) {
+        if (n <= cap) return;
+        T* p = new T[n];
+        copy(ptr, ptr + count, p);
+        release();
+        ptr = p;
+        cap = n;
+    }
+
+    void push_back(const T& v) {
+        if (count == cap) {
+            const T value = v;  // v may be an element
+            reserve(2 * cap);
+            ptr[count++] = value;
+        } else {
+            ptr[count++] = v;
+        }
+    }
+
+    void assign(size_t n, const T& v) {
+        const T value = v;
+        count = 0;
+        reserve(n);
+        fill(ptr, ptr + n, value);
+        count = n;
+    }
+
+    template <class It, class = enable_if_t<!is_integral<It>::value>>
+    void assign(It first, It last) {
+        const size_t n = static_cast<size_t>(distance(first, last));
+        count = 0;
+        reserve(n);
+        copy(first, last, ptr);
+        count = n;
+    }
+
+    // Inserts n copies of v before pos
+    iterator insert(const_iterator pos, size_t n, const T& v) {
+        const size_t at = static_cast<size_t>(pos - ptr);
+        const T value = v;
+        reserve(count + n);
+        copy_backward(ptr + at, ptr + count, ptr + count + n);
+        fill(ptr + at, ptr + at + n, value);
+        count += n;
+        return ptr + at;
+    }
+
+    void clear() noexcept { count = 0; }
+
+    friend bool operator==(const SmallVector& a, const SmallVector& b) {
+        return equal(a.begin(), a.end(), b.begin(), b.end());
+    }
+    friend bool operator!=(const SmallVector& a, const SmallVector& b) { return !(a == b); }
+
+private:
+    T* ptr;
+    size_t count;
+    size_t cap;
+    T local[N];
+
+    void release() noexcept {
+        if (ptr != local) delete[] ptr;
+        ptr = local;
+        cap = N;
+    }
+
+    // Adopts other's elements (its heap buffer, or a copy of its inline ones) and leaves it empty
+    void take(SmallVector& other) noexcept {
+        if (other.ptr == other.local) {
+            copy(other.local, other.local + other.count, local);
+        } else {
+            ptr = other.ptr;
+            cap = other.cap;
+            other.ptr = other.local;
+            other.cap = N;
+        }
+        count = other.count;
+        other.count = 0;
+    }
+};
+
+#endif  // SMALLVECTOR_H
@@ -0,0 +1,870 @@
+#ifndef SOLVE_H
+#define SOLVE_H
+
+#include <vector>
+#include <stdexcept>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include "Matrix.h"
+
+using namespace std;
+
+// Direct solvers for A * X = B with any number of right-hand sides (the columns of B).
+// Every decomposition is an object: factor once, then call solve() as often as needed.
+// A quick one-off solve is solve(A, B); see also LUDecomposition::solve in Matrix.h.
+
+// Cholesky decomposition A = L * L^T of a symmetric positive-definite matrix.
+// Only the lower triangle of A is read. Half the work of LU and no pivoting.
+template <class T>
+class CholeskyDecomposition {
+public:
+    explicit CholeskyDecomposition(const BasicMatrix<T>& a) : l(a) {
+        if (a.getRow() != a.getCol()) {
+            throw invalid_argument("Cholesky decomposition requires a square matrix.");
+        }
+        factorize();
+    }
+
+    int size() const { return l.getRow(); }
+
+    T determinant() const {
+        T d = 1;
+        for (int k = 0; k < size(); k++) {
+            d *= l(k, k) * l(k, k);
+        }
+        return d;
+    }
+
+    BasicMatrix<T> solve(const BasicMatrix<T>& B) const {
+        BasicMatrix<T> X(B);
+        solveInPlace(X);
+        return X;
+    }
+
+    vector<T> solve(const vector<T>& b) const {
+        BasicMatrix<T> x(static_cast<int>(b.size()), 1);
+        copy(b.begin(), b.end(), x.data());
+        solveInPlace(x);
+        return vector<T>(x.data(), x.data() + b.size());
+    }
+
+    void solveInPlace(BasicMatrix<T>& B) const {
+        solveInPlace(B.block(0, 0, B.getRow(), B.getCol()));
+    }
+
+    // L * Y = B, then L^T * X = Y; L^T is L read with swapped strides
+    void solveInPlace(const BlockView<T>& B) const {
+        if (B.getRow() != size()) {
+            throw runtime_error("Matrix dimensions do not match for solve!");
+        }
+        const int n = size();
+        trsm<T>(true, false, n, B.getCol(), l.data(), n, 1, B.p, B.ld);
+        trsm<T>(false, false, n, B.getCol(), l.data(), 1, n, B.p, B.ld);
+    }
+
+    BasicMatrix<T> getL() const {
+        const int n = size();
+        BasicMatrix<T> L(n, n);
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j <= i; j++) {
+                L(i, j) = l(i, j);
+            }
+        }
+        return L;
+    }
+
+private:
+    BasicMatrix<T> l;  // L in the lower triangle; the strict upper triangle is scratch
+
+    static constexpr int chol_block = 64;
+
+    // Right-looking blocked Cholesky: factor the diagonal block, solve the rows below it
+    // against L11^T (independent rows, split across threads), then update the lower part
+    // of the trailing matrix with GEMM one block row at a time.
+    void factorize() {
+        const int n = size();
+        T* a = l.data();
+        const int nb = n < 2 * chol_block ? n : chol_block;
+        for (int k0 = 0; k0 < n; k0 += nb) {
+            const int kend = min(n, k0 + nb);
+            for (int j = k0; j < kend; j++) {
+                T* rj = a + static_cast<size_t>(j) * n;
+                T d = rj[j];
+                for (int p = k0; p < j; p++) d -= rj[p] * rj[p];
+                if (!(d > 0)) {
+                    throw runtime_error("Matrix is not positive definite!");
+                }
+                rj[j] = sqrt(d);
+                for (int i = j + 1; i < kend; i++) {
+                    T* ri = a + static_cast<size_t>(i) * n;
+                    T s = ri[j];
+                    for (int p = k0; p < j; p++) s -= ri[p] * rj[p];
+                    ri[j] = s / rj[j];
+                }
+            }
+            if (kend == n) break;
+
+            // L21 = A21 * L11^-T, one row at a time
+            parallelFor(kend, n, static_cast<size_t>(kend - k0) * (kend - k0), [=](size_t lo, size_t hi) {
+                for (size_t i = lo; i < hi; i++) {
+                    T* ri = a + i * n;
+                    for (int j = k0; j < kend; j++) {
+                        const T* rj = a + static_cast<size_t>(j) * n;
+                        T s = ri[j];
+                        for (int p = k0; p < j; p++) s -= ri[p] * rj[p];
+                        ri[j] = s / rj[j];
+                    }
+                }
+            });
+
+            // A22 -= L21 * L21^T, lower triangle only (block rows stop at their diagonal block)
+            for (int r0 = kend; r0 < n; r0 += nb) {
+                const int r1 = min(n, r0 + nb);
+                gemm<T>(r1 - r0, r1 - kend, kend - k0, T(-1),
+                        a + static_cast<size_t>(r0) * n + k0, n, 1,
+                        a + static_cast<size_t>(kend) * n + k0, 1, n,
+                        T(1), a + static_cast<size_t>(r0) * n + kend, n);
+            }
+        }
+    }
+};
+
+namespace householder_detail {
+
+// Triangular factor T of the compact WY form H_0 * ... * H_(kb-1) = I - V * T * V^T (LAPACK larft,
+// forward column-wise). V is mk x kb with row stride ldv, its unit diagonal and the zeros above it
+// stored explicitly; tau holds the kb reflector scales and t receives kb x kb entries (row stride ldt).
+template <class T>
+void formT(int mk, int kb, const T* V, ptrdiff_t ldv, const T* tau, T* t, int ldt) {
+    vector<T> z(kb);
+    for (int i = 0; i < kb; i++) {
+        for (int p = 0; p < i; p++) {
+            T s = 0;
+            for (int r = i; r < mk; r++) s += V[r * ldv + p] * V[r * ldv + i];
+            z[p] = s;
+        }
+        for (int p = 0; p < i; p++) {
+            T s = 0;
+            for (int q = p; q < i; q++) s += t[p * ldt + q] * z[q];
+            t[p * ldt + i] = -tau[i] * s;
+        }
+        t[i * ldt + i] = tau[i];
+    }
+}
+
+// C = (I - V * T * V^T) * C, or its transpose applied when transpose is set, for the mk x ncols block C
+// (row stride ldc): W = V^T * C and C -= V * op(T) * W are GEMMs, op(T) * W is a small triangular product.
+template <class T>
+void applyBlockReflector(int mk, int kb, const T* V, ptrdiff_t ldv, const T* t, int ldt,
+                         T* c, ptrdiff_t ldc, int ncols, bool transpose) {
+    if (kb <= 0 || ncols <= 0) return;
+    vector<T> w(static_cast<size_t>(kb) * ncols);
+    gemm<T>(kb, ncols, mk, T(1), V, 1, ldv, c, ldc, 1, T(0), w.data(), ncols);
+
+    // W = op(T) * W in place. T^T is lower triangular, so rows are rewritten bottom-up; T top-down.
+    for (int s = 0; s < kb; s++) {
+        const int i = transpose ? kb - 1 - s : s;
+        T* wi = w.data() + static_cast<size_t>(i) * ncols;
+        const T tii = t[i * ldt + i];
+        for (int j = 0; j < ncols; j++) wi[j] *= tii;
+        const int p0 = transpose ? 0 : i + 1;
+        const int p1 = transpose ? i : kb;
+        for (int p = p0; p < p1; p++) {
+            const T tp = transpose ? t[p * ldt + i] : t[i * ldt + p];
+            if (tp == T(0)) continue;
+            const T* wp = w.data() + static_cast<size_t>(p) * ncols;
+            for (int j = 0; j < ncols; j++) wi[j] += tp * wp[j];
+        }
+    }
+
+    gemm<T>(mk, ncols, kb, T(-1), V, ldv, 1, w.data(), ncols, 1, T(1), c, ldc);
+}
+
+}  // namespace householder_detail
+
+// Householder QR decomposition A = Q * R of an m x n matrix with m >= n.
+// Q = H_0 * H_1 * ... * H_(n-1) with H_k = I - tau_k * v_k * v_k^T. The reflectors are kept in
+// blocks of qr_block columns together with the triangular factor T of their compact WY form
+// (H_k0 * ... * H_k1 = I - V * T * V^T), so applying Q^T to the right-hand sides is two GEMMs per block.
+template <class T>
+class QRDecomposition {
+public:
+    explicit QRDecomposition(const BasicMatrix<T>& a) : v(a), r(a.getCol(), a.getCol()), tau(a.getCol()), fullRank(true) {
+        if (a.getRow() < a.getCol()) {
+            throw invalid_argument("QR decomposition requires at least as many rows as columns.");
+        }
+        factorize();
+    }
+
+    int rows() const { return v.getRow(); }
+    int cols() const { return v.getCol(); }
+
+    // False when some |r_kk| is below max(m, n) * eps * max|a_ij|; solve() then refuses
+    bool isFullRank() const { return fullRank; }
+
+    // Least-squares solution: the X minimizing ||A * X - B|| column by column (exact when A is square)
+    BasicMatrix<T> solve(const BasicMatrix<T>& B) const {
+        if (B.getRow() != rows()) {
+            throw runtime_error("Matrix dimensions do not match for solve!");
+        }
+        if (!fullRank) {
+            throw runtime_error("Matrix is rank deficient!");
+        }
+        const int n = cols();
+        const int nrhs = B.getCol();
+        BasicMatrix<T> C(B);
+        applyQT(C);
+        BasicMatrix<T> X(n, nrhs);
+        copy(C.data(), C.data() + static_cast<size_t>(n) * nrhs, X.data());
+        trsm<T>(false, false, n, nrhs, r.data(), n, 1, X.data(), nrhs);
+        return X;
+    }
+
+    vector<T> solve(const vector<T>& b) const {
+        BasicMatrix<T> B(static_cast<int>(b.size()), 1);
+        copy(b.begin(), b.end(), B.data());
+        BasicMatrix<T> x = solve(B);
+        return vector<T>(x.data(), x.data() + cols());
+    }
+
+    // B = Q^T * B (B must have rows() rows)
+    void applyQT(BasicMatrix<T>& B) const {
+        if (B.getRow() != rows()) {
+            throw runtime_error("Matrix dimensions do not match for multiplication!");
+        }
+        for (int k0 = 0; k0 < cols(); k0 += qr_block) {
+            applyBlock(k0, B.data(), B.getCol(), B.getLd(), true);
+        }
+    }
+
+    // B = Q * B (B must have rows() rows)
+    void applyQ(BasicMatrix<T>& B) const {
+        if (B.getRow() != rows()) {
+            throw runtime_error("Matrix dimensions do not match for multiplication!");
+        }
+        const int blocks = (cols() + qr_block - 1) / qr_block;
+        for (int b = blocks - 1; b >= 0; b--) {
+            applyBlock(b * qr_block, B.data(), B.getCol(), B.getLd(), false);
+        }
+    }
+
+    // Thin Q: the first n columns of Q (m x n, orthonormal columns)
+    BasicMatrix<T> getQ() const {
+        BasicMatrix<T> Q(rows(), cols());
+        for (int k = 0; k < cols(); k++) Q(k, k) = 1;
+        applyQ(Q);
+        return Q;
+    }
+
+    const BasicMatrix<T>& getR() const { return r; }
+
+private:
+    BasicMatrix<T> v;     // Householder vectors, unit diagonal and zeros above it stored explicitly
+    BasicMatrix<T> r;     // n x n upper triangular factor
+    vector<T> tau;
+    vector<T> tBlocks;    // qr_block x qr_block upper triangular T per column block
+    bool fullRank;
+
+    static constexpr int qr_block = 32;
+
+    // Column k0's block of reflectors applied to the rows k0.. of C (ncols columns, row stride ldc)
+    void applyBlock(int k0, T* c, int ncols, ptrdiff_t ldc, bool transposeQ) const {
+        const int n = cols();
+        householder_detail::applyBlockReflector(rows() - k0, min(qr_block, n - k0),
+                                                v.data() + static_cast<size_t>(k0) * n + k0, n,
+                                                tBlocks.data() + static_cast<size_t>(k0 / qr_block) * qr_block * qr_block, qr_block,
+                                                c + static_cast<size_t>(k0) * ldc, ldc, ncols, transposeQ);
+    }
+
+    // Blocked Householder QR: reduce a panel of qr_block columns with unblocked reflectors,
+    // form its T factor, and apply the whole block to the trailing columns with GEMM.
+    void factorize() {
+        const int m = rows(), n = cols();
+        BasicMatrix<T> work(v);
+        T* a = work.data();
+        T* vp = v.data();
+        fill(vp, vp + static_cast<size_t>(m) * n, T(0));
+        tBlocks.assign(static_cast<size_t>((n + qr_block - 1) / qr_block) * qr_block * qr_block, T(0));
+
+        T maxAbs = 0;
+        for (size_t k = 0; k < static_cast<size_t>(m) * n; k++) {
+            maxAbs = max(maxAbs, static_cast<T>(fabs(a[k])));
+        }
+        const T tol = numeric_limits<T>::epsilon() * m * maxAbs;
+
+        for (int k0 = 0; k0 < n; k0 += qr_block) {
+            const int kend = min(n, k0 + qr_block);
+            for (int k = k0; k < kend; k++) {
+                householder(a, k);
+                applyReflector(a, k, k + 1, kend);
+            }
+            householder_detail::formT(m - k0, kend - k0, v.data() + static_cast<size_t>(k0) * n + k0, n, tau.data() + k0,
+                                      tBlocks.data() + static_cast<size_t>(k0 / qr_block) * qr_block * qr_block, qr_block);
+            if (kend < n) {
+                applyBlock(k0, a + kend, n - kend, n, true);
+            }
+        }
+
+        for (int i = 0; i < n; i++) {
+            copy(a + static_cast<size_t>(i) * n + i, a + static_cast<size_t>(i + 1) * n, r.data() + static_cast<size_t>(i) * n + i);
+            if (fabs(r(i, i)) <= tol) fullRank = false;
+        }
+    }
+
+    // Reflector that zeroes a[k+1:, k]: stores v_k (v_k[k] = 1) in v, tau_k, and beta on the diagonal of a
+    void householder(T* a, int k) {
+        const int m = rows(), n = cols();
+        const T alpha = a[static_cast<size_t>(k) * n + k];
+        T sigma = 0;
+        for (int i = k + 1; i < m; i++) {
+            const T x = a[static_cast<size_t>(i) * n + k];
+            sigma += x * x;
+        }
+        v(k, k) = 1;
+        if (sigma == 0) {
+            tau[k] = 0;
+            return;
+        }
+        const T norm = sqrt(alpha * alpha + sigma);
+        const T beta = alpha <= 0 ? norm : -norm;
+        tau[k] = (beta - alpha) / beta;
+        const T scale = T(1) / (alpha - beta);
+        for (int i = k + 1; i < m; i++) {
+            T& x = a[static_cast<size_t>(i) * n + k];
+            v(i, k) = x * scale;
+            x = 0;
+        }
+        a[static_cast<size_t>(k) * n + k] = beta;
+    }
+
+    // Columns [j0, j1) of a = H_k * a (the rest of the current panel)
+    void applyReflector(T* a, int k, int j0, int j1) const {
+        const int m = rows(), n = cols();
+        if (j0 >= j1 || tau[k] == 0) return;
+        vector<T> w(j1 - j0, T(0));
+        for (int i = k; i < m; i++) {
+            const T vi = v(i, k);
+            const T* ai = a + static_cast<size_t>(i) * n + j0;
+            for (int j = 0; j < j1 - j0; j++) w[j] += vi * ai[j];
+        }
+        for (int i = k; i < m; i++) {
+            const T s = tau[k] * v(i, k);
+            T* ai = a + static_cast<size_t>(i) * n + j0;
+            for (int j = 0; j < j1 - j0; j++) ai[j] -= s * w[j];
+        }
+    }
+};
+
+// Inverse and determinant of a square matrix kept current under cheap changes: rank-k updates
+// A += U * V^T through the Sherman-Morrison-Woodbury formula, element, row and column changes as
+// rank-1 updates, and appended rows and columns by bordering with the Schur complement. Each costs
+// O(n^2 k) instead of the O(n^3) of inverting again. Rounding errors accumulate across updates, so a
+// residual probe runs every checkEvery updates, and right away after an update much larger than the
+// inverse it leaves behind (cancellation); a failed probe or a near-singular update triggers a fresh LU.
+template <class T>
+class UpdatableInverse {
+public:
+    explicit UpdatableInverse(const BasicMatrix<T>& m)
+        : a(m), inv(), det(0), singular(false), sinceFactor(0), checkEvery(8),
+          tolerance(sqrt(numeric_limits<T>::epsilon())), factorizations(0) {
+        if (m.getRow() != m.getCol()) {
+            throw invalid_argument("UpdatableInverse requires a square matrix.");
+        }
+        refactor();
+    }
+
+    int size() const { return a.getRow(); }
+
+    // The current matrix, with every update applied
+    const BasicMatrix<T>& matrix() const { return a; }
+
+    const BasicMatrix<T>& inverse() const {
+        if (singular) {
+            throw runtime_error("Matrix is not invertible!");
+        }
+        return inv;
+    }
+
+    T determinant() const { return singular ? T(0) : det; }
+    // Singular to working precision (LUDecomposition::isNearlySingular): no inverse is kept that could not be trusted
+    bool isSingular() const { return singular; }
+
+    // x = A^-1 * b, O(n^2) from the kept inverse
+    vector<T> solve(const vector<T>& b) const {
+        if (static_cast<int>(b.size()) != size()) {
+            throw runtime_error("Matrix dimensions do not match for solve!");
+        }
+        vector<T> x(size());
+        multiplyVector(inverse(), b.data(), x.data());
+        return x;
+    }
+
+    // A += U * V^T for n x k matrices U and V
+    void update(const BasicMatrix<T>& U, const BasicMatrix<T>& V) {
+        const int n = size(), k = U.getCol();
+        if (U.getRow() != n || V.getRow() != n || V.getCol() != k) {
+            throw runtime_error("Matrix dimensions do not match for update!");
+        }
+        gemm<T>(n, n, k, T(1), U.data(), U.getLd(), 1, V.data(), 1, V.getLd(), T(1), a.data(), a.getLd());
+        if (singular) {
+            refactor();
+            return;
+        }
+        // X = A^-1 * U, Y = V^T * A^-1, K = I + V^T * X
+        BasicMatrix<T> X(n, k), Y(k, n), K(k, k);
+        gemm<T>(n, k, n, T(1), inv.data(), inv.getLd(), 1, U.data(), U.getLd(), 1, T(0), X.data(), k);
+        gemm<T>(k, n, n, T(1), V.data(), 1, V.getLd(), inv.data(), inv.getLd(), 1, T(0), Y.data(), n);
+        gemm<T>(k, k, n, T(1), V.data(), 1, V.getLd(), X.data(), k, 1, T(0), K.data(), k);
+        for (int p = 0; p < k; p++) K(p, p) += 1;
+        woodbury(X, Y, K);
+    }
+
+    // A += u * v^T (Sherman-Morrison)
+    void update(const vector<T>& u, const vector<T>& v) {
+        const int n = size();
+        if (static_cast<int>(u.size()) != n || static_cast<int>(v.size()) != n) {
+            throw runtime_error("Matrix dimensions do not match for update!");
+        }
+        BasicMatrix<T> U(n, 1), V(n, 1);
+        copy(u.begin(), u.end(), U.data());
+        copy(v.begin(), v.end(), V.data());
+        update(U, V);
+    }
+
+    // A(i, j) = value: u = (value - a_ij) e_i, v = e_j, so A^-1 u is a scaled column of the inverse
+    void setElementAt(int i, int j, T value) {
+        const int n = size();
+        if (i < 0 || i >= n || j < 0 || j >= n) {
+            throw runtime_error("Index out of bounds!");
+        }
+        const T delta = value - a(i, j);
+        a(i, j) = value;
+        if (delta == T(0)) return;
+        if (singular) {
+            refactor();
+            return;
+        }
+        BasicMatrix<T> X(n, 1), Y(1, n), K(1, 1);
+        for (int r = 0; r < n; r++) X(r, 0) = delta * inv(r, i);
+        copy(inv.data() + static_cast<size_t>(j) * inv.getLd(), inv.data() + static_cast<size_t>(j) * inv.getLd() + n, Y.data());
+        K(0, 0) = 1 + X(j, 0);
+        woodbury(X, Y, K);
+    }
+
+    // Row i of A replaced: u = e_i, v = newRow - a_i
+    void setRow(int i, const vector<T>& newRow) {
+        const int n = size();
+        if (i < 0 || i >= n) {
+            throw runtime_error("Index out of bounds!");
+        }
+        if (static_cast<int>(newRow.size()) != n) {
+            throw invalid_argument("Row length must be equal to col. ");
+        }
+        vector<T> v(n);
+        for (int j = 0; j < n; j++) {
+            v[j] = newRow[j] - a(i, j);
+            a(i, j) = newRow[j];
+        }
+        if (singular) {
+            refactor();
+            return;
+        }
+        BasicMatrix<T> X(n, 1), Y(1, n), K(1, 1);
+        for (int r = 0; r < n; r++) X(r, 0) = inv(r, i);
+        multiplyVectorTransposed(inv, v.data(), Y.data());
+        T s = 1;
+        for (int j = 0; j < n; j++) s += v[j] * X(j, 0);
+        K(0, 0) = s;
+        woodbury(X, Y, K);
+    }
+
+    // Column j of A replaced: u = newCol - a_:j, v = e_j
+    void setCol(int j, const vector<T>& newCol) {
+        const int n = size();
+        if (j < 0 || j >= n) {
+            throw runtime_error("Index out of bounds!");
+        }
+        if (static_cast<int>(newCol.size()) != n) {
+            throw invalid_argument("The number of elements in the new column must match the number of rows.");
+        }
+        vector<T> u(n);
+        for (int i = 0; i < n; i++) {
+            u[i] = newCol[i] - a(i, j);
+            a(i, j) = newCol[i];
+        }
+        if (singular) {
+            refactor();
+            return;
+        }
+        BasicMatrix<T> X(n, 1), Y(1, n), K(1, 1);
+        multiplyVector(inv, u.data(), X.data());
+        copy(inv.data() + static_cast<size_t>(j) * inv.getLd(), inv.data() + static_cast<size_t>(j) * inv.getLd() + n, Y.data());
+        K(0, 0) = 1 + X(j, 0);
+        woodbury(X, Y, K);
+    }
+
+    // Bordering: A becomes [A B; C D] for B (n x k), C (k x n) and D (k x k). With the Schur complement
+    // S = D - C * A^-1 * B the new inverse is [A^-1 + W * S^-1 * Y, -W * S^-1; -S^-1 * Y, S^-1] where
+    // W = A^-1 * B and Y = C * A^-1, and det is multiplied by det(S). The inverse grows in place.
+    void append(const BasicMatrix<T>& B, const BasicMatrix<T>& C, const BasicMatrix<T>& D) {
+        const int n = size(), k = D.getRow();
+        if (D.getCol() != k || B.getRow() != n || B.getCol() != k || C.getRow() != k || C.getCol() != n) {
+            throw runtime_error("Matrix dimensions do not match for append!");
+        }
+        BasicMatrix<T> lowerRows(k, n + k);
+        lowerRows.block(0, 0, k, n) = C;
+        lowerRows.block(0, n, k, k) = D;
+        a.append_cols(B);
+        a.append_rows(lowerRows);
+        if (singular) {
+            refactor();
+            return;
+        }
+        BasicMatrix<T> W(n, k), Y(k, n), S(D);
+        gemm<T>(n, k, n, T(1), inv.data(), inv.getLd(), 1, B.data(), B.getLd(), 1, T(0), W.data(), k);
+        gemm<T>(k, n, n, T(1), C.data(), C.getLd(), 1, inv.data(), inv.getLd(), 1, T(0), Y.data(), n);
+        gemm<T>(k, k, n, T(-1), C.data(), C.getLd(), 1, W.data(), k, 1, T(1), S.data(), k);
+        LUDecomposition<T> f(S);
+        if (nearlySingular(f, D, S)) {
+            refactor();
+            return;
+        }
+        BasicMatrix<T> Sinv = f.inverse();
+        BasicMatrix<T> SinvY = Sinv * Y;
+        BasicMatrix<T> WSinv = W * Sinv;
+        const T growth = addProduct(WSinv, Y, T(1));
+        lowerRows.block(0, 0, k, n) = -SinvY;
+        lowerRows.block(0, n, k, k) = Sinv;
+        inv.append_cols(-WSinv);
+        inv.append_rows(lowerRows);
+        det *= f.determinant();
+        afterUpdate(growth);
+    }
+
+    // One new row and column: newCol holds the n entries above the corner, newRow the n to its left
+    void append(const vector<T>& newCol, const vector<T>& newRow, T corner) {
+        const int n = size();
+        if (static_cast<int>(newCol.size()) != n || static_cast<int>(newRow.size()) != n) {
+            throw runtime_error("Matrix dimensions do not match for append!");
+        }
+        BasicMatrix<T> B(n, 1), C(1, n), D(1, 1);
+        copy(newCol.begin(), newCol.end(), B.data());
+        copy(newRow.begin(), newRow.end(), C.data());
+        D(0, 0) = corner;
+        append(B, C, D);
+    }
+
+    // Recomputes the inverse and determinant from the current matrix with a pivoted LU
+    void refactor() {
+        LUDecomposition<T> f(a);
+        singular = f.isNearlySingular();
+        det = f.determinant();
+        inv = singular ? BasicMatrix<T>() : f.inverse();
+        sinceFactor = 0;
+        factorizations++;
+    }
+
+    // The residual probe runs every checkEvery updates (and after any update that cancelled heavily),
+    // and refactors when
+    // |A * (A^-1 * p) - p| > tolerance * (|A| * |A^-1 * p| + |p|) (infinity norms)
+    void setRefactorPolicy(int checkEveryUpdates, T relativeTolerance) {
+        if (checkEveryUpdates < 1 || !(relativeTolerance > 0)) {
+            throw invalid_argument("Refactor policy needs a positive interval and tolerance.");
+        }
+        checkEvery = checkEveryUpdates;
+        tolerance = relativeTolerance;
+    }
+
+    // LU factorizations so far, counting the one in the constructor
+    int refactorizations() const { return factorizations; }
+
+private:
+    BasicMatrix<T> a;
+    BasicMatrix<T> inv;
+    T det;
+    bool singular;
+    int sinceFactor;
+    int checkEvery;
+    T tolerance;
+    int factorizations;
+
+    // A^-1 -= X * K^-1 * Y and det *= det(K), unless K is too close to singular for the update to be trusted
+    void woodbury(const BasicMatrix<T>& X, BasicMatrix<T>& Y, const BasicMatrix<T>& K) {
+        const int k = K.getRow();
+        LUDecomposition<T> f(K);
+        BasicMatrix<T> I(k, k);
+        I.identity();
+        if (nearlySingular(f, I, K)) {
+            refactor();
+            return;
+        }
+        f.solveInPlace(Y);
+        const T growth = addProduct(X, Y, T(-1));
+        det *= f.determinant();
+        afterUpdate(growth);
+    }
+
+    // The small k x k system the update divides by (K = base + correction) has lost most of its digits
+    // to cancellation: its smallest pivot is tiny next to the terms that formed it
+    bool nearlySingular(const LUDecomposition<T>& f, const BasicMatrix<T>& base, const BasicMatrix<T>& K) const {
+        if (f.isNearlySingular()) return true;
+        T scale = 0;
+        for (int i = 0; i < K.getRow(); i++) {
+            for (int j = 0; j < K.getCol(); j++) {
+                scale = max(scale, max(static_cast<T>(fabs(base(i, j))), static_cast<T>(fabs(K(i, j) - base(i, j)))));
+            }
+        }
+        T pivot = numeric_limits<T>::max();
+        for (int p = 0; p < K.getRow(); p++) {
+            pivot = min(pivot, static_cast<T>(fabs(f.getPacked()(p, p))));
+        }
+        return pivot <= tolerance * scale;
+    }
+
+    // A^-1 += sign * X * Y (X is n x k, Y is k x n), rows split across threads. Returns how many times
+    // larger the added term may be than the largest entry left in A^-1: rounding errors of the old
+    // entries are amplified by that much relative to the new ones.
+    T addProduct(const BasicMatrix<T>& X, const BasicMatrix<T>& Y, T sign) {
+        const int n = inv.getRow(), k = X.getCol();
+        vector<T> rowMax(n);
+        parallelFor(0, n, static_cast<size_t>(n) * k, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; i++) {
+                T* ri = inv.data() + i * inv.getLd();
+                for (int p = 0; p < k; p++) {
+                    const T x = sign * X(static_cast<int>(i), p);
+                    const T* yp = Y.data() + static_cast<size_t>(p) * Y.getLd();
+                    for (int j = 0; j < n; j++) ri[j] += x * yp[j];
+                }
+                T m = 0;
+                for (int j = 0; j < n; j++) m = max(m, static_cast<T>(fabs(ri[j])));
+                rowMax[i] = m;
+            }
+        });
+        T xMax = 0, yMax = 0;
+        for (int i = 0; i < n; i++) {
+            for (int p = 0; p < k; p++) xMax = max(xMax, static_cast<T>(fabs(X(i, p))));
+        }
+        for (int p = 0; p < k; p++) {
+            for (int j = 0; j < n; j++) yMax = max(yMax, static_cast<T>(fabs(Y(p, j))));
+        }
+        const T invMax = *max_element(rowMax.begin(), rowMax.end());
+        return invMax > 0 ? k * xMax * yMax / invMax : numeric_limits<T>::infinity();
+    }
+
+    void afterUpdate(T growth) {
+        // Cancellation costs about log10(growth) digits; probe once that could exceed the tolerance
+        const bool suspect = growth * numeric_limits<T>::epsilon() > tolerance;
+        if ((++sinceFactor % checkEvery == 0 || suspect) && drifted()) refactor();
+    }
+
+    bool drifted() const {
+        const int n = size();
+        vector<T> p(n), y(n), r(n);
+        for (int i = 0; i < n; i++) p[i] = (i % 2 ? T(-1) : T(1)) * T(1 + i % 7) / T(7);
+        multiplyVector(inv, p.data(), y.data());
+        multiplyVector(a, y.data(), r.data());
+        T res = 0, normA = 0, normY = 0, normP = 0;
+        for (int i = 0; i < n; i++) {
+            res = max(res, static_cast<T>(fabs(r[i] - p[i])));
+            normY = max(normY, static_cast<T>(fabs(y[i])));
+            normP = max(normP, static_cast<T>(fabs(p[i])));
+            T rowSum = 0;
+            for (int j = 0; j < n; j++) rowSum += fabs(a(i, j));
+            normA = max(normA, rowSum);
+        }
+        return !(res <= tolerance * (normA * normY + normP));
+    }
+
+    // y = M * x, rows split across threads
+    static void multiplyVector(const BasicMatrix<T>& M, const T* x, T* y) {
+        const int n = M.getCol();
+        parallelFor(0, M.getRow(), n, [&M, x, y, n](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; i++) {
+                const T* mi = M.data() + i * M.getLd();
+                T s = 0;
+                for (int j = 0; j < n; j++) s += mi[j] * x[j];
+                y[i] = s;
+            }
+        });
+    }
+
+    // y = M^T * x, accumulated row by row so the inner loop stays contiguous; columns split across threads
+    static void multiplyVectorTransposed(const BasicMatrix<T>& M, const T* x, T* y) {
+        const int m = M.getRow();
+        parallelFor(0, M.getCol(), m, [&M, x, y, m](size_t lo, size_t hi) {
+            fill(y + lo, y + hi, T(0));
+            for (int i = 0; i < m; i++) {
+                const T* mi = M.data() + static_cast<size_t>(i) * M.getLd();
+                const T xi = x[i];
+                for (size_t j = lo; j < hi; j++) y[j] += xi * mi[j];
+            }
+        });
+    }
+};
+
+// LU in a fast working precision (Work = double or float, where GEMM and the triangular solves use
+// SIMD kernels) with iterative refinement in the matrix's own precision T (long double by default):
+// X = LU^-1 * B, then repeatedly R = B - A * X in T and X += LU^-1 * R, as LAPACK's dsgesv does.
+// Each step gains about -log10(cond(A) * eps(Work)) digits, so well-conditioned systems reach
+// T accuracy in a few O(n^2) steps after an O(n^3) factorization that runs at Work speed.
+// A system too ill-conditioned for Work to converge is solved with an LU in T instead.
+template <class Work, class T = long double>
+class MixedPrecisionLU {
+public:
+    explicit MixedPrecisionLU(const BasicMatrix<T>& m, int maxIterations = 30)
+        : a(m), low(toWork(m)), maxIter(maxIterations), fallback(make_shared<Fallback>()) {
+        if (m.getRow() != m.getCol()) {
+            throw invalid_argument("LU decomposition requires a square matrix.");
+        }
+        T maxAbs = 0;
+        for (int i = 0; i < a.getRow(); i++) {
+            T rowSum = 0;
+            for (int j = 0; j < a.getCol(); j++) {
+                rowSum += fabs(a(i, j));
+                maxAbs = max(maxAbs, static_cast<T>(fabs(a(i, j))));
+            }
+            normA = max(normA, rowSum);
+        }
+        // Entries beyond Work's range cannot be factorized in it
+        inRange = maxAbs <= static_cast<T>(numeric_limits<Work>::max());
+        if (inRange) lowLU = make_shared<LUDecomposition<Work>>(low);
+    }
+
+    int size() const { return a.getRow(); }
+
+    // X = A^-1 * B to about T precision. iterations, when given, receives the number of refinement
+    // steps, or -1 if the system needed the full-precision LU.
+    BasicMatrix<T> solve(const BasicMatrix<T>& B, int* iterations = nullptr) const {
+        const int n = size(), nrhs = B.getCol();
+        if (B.getRow() != n) {
+            throw runtime_error("Matrix dimensions do not match for solve!");
+        }
+        if (inRange && !lowLU->isNearlySingular()) {
+            BasicMatrix<Work> d = toWork(B);
+            lowLU->solveInPlace(d);
+            BasicMatrix<T> X = elementCast<T>(d);
+            // Converged once the residual is at rounding level in T: |R| <= sqrt(n) * eps(T) * |A| * |X|
+            const T eps = numeric_limits<T>::epsilon() * sqrt(static_cast<T>(n));
+            BasicMatrix<T> R(n, nrhs);
+            T lastCorrection = numeric_limits<T>::infinity();
+            for (int it = 0; it <= maxIter; it++) {
+                R = B;
+                gemm<T>(n, nrhs, n, T(-1), a.data(), a.getLd(), 1, X.data(), X.getLd(), 1, T(1), R.data(), R.getLd());
+                if (maxNorm(R) <= eps * normA * maxNorm(X)) {
+                    if (iterations) *iterations = it;
+                    return X;
+                }
+                d = elementCast<Work>(R);
+                lowLU->solveInPlace(d);
+                const T correction = maxNorm(d);
+                // Corrections must shrink steadily; otherwise A is too ill-conditioned for Work
+                if (!(correction <= lastCorrection / 2) || it == maxIter) break;
+                lastCorrection = correction;
+                X += elementCast<T>(d);
+            }
+        }
+        if (iterations) *iterations = -1;
+        return fullLU().solve(B);
+    }
+
+    vector<T> solve(const vector<T>& b, int* iterations = nullptr) const {
+        BasicMatrix<T> B(static_cast<int>(b.size()), 1);
+        copy(b.begin(), b.end(), B.data());
+        BasicMatrix<T> x = solve(B, iterations);
+        return vector<T>(x.data(), x.data() + b.size());
+    }
+
+private:
+    // Built on first use and shared by copies; solve() may run on several threads at once
+    struct Fallback {
+        once_flag once;
+        unique_ptr<LUDecomposition<T>> lu;
+    };
+
+    BasicMatrix<T> a;
+    BasicMatrix<Work> low;
+    shared_ptr<LUDecomposition<Work>> lowLU;
+    int maxIter;
+    T normA = 0;
+    bool inRange = false;
+    shared_ptr<Fallback> fallback;
+
+    static BasicMatrix<Work> toWork(const BasicMatrix<T>& m) { return elementCast<Work>(m); }
+
+    template <class U>
+    static T maxNorm(const BasicMatrix<U>& m) {
+        T worst = 0;
+        for (int i = 0; i < m.getRow(); i++) {
+            for (int j = 0; j < m.getCol(); j++) worst = max(worst, static_cast<T>(fabs(m(i, j))));
+        }
+        return worst;
+    }
+
+    const LUDecomposition<T>& fullLU() const {
+        call_once(fallback->once, [this] { fallback->lu = make_unique<LUDecomposition<T>>(a); });
+        return *fallback->lu;
+    }
+};
+
+// Factorizations and solve() accept views and other expressions as well as matrices;
+// anything that is not already a Matrix is copied once, which the factorization needs anyway.
+template <class T>
+const BasicMatrix<T>& solveOperand(const BasicMatrix<T>& m) { return m; }
+
+template <class E>
+BasicMatrix<typename E::value_type> solveOperand(const MatrixExpr<E>& e) { return e.eval(); }
+
+template <class E>
+CholeskyDecomposition<typename E::value_type> cholesky(const MatrixExpr<E>& a) {
+    return CholeskyDecomposition<typename E::value_type>(solveOperand(a.self()));
+}
+
+template <class E>
+QRDecomposition<typename E::value_type> qr(const MatrixExpr<E>& a) {
+    return QRDecomposition<typename E::value_type>(solveOperand(a.self()));
+}
+
+template <class E>
+UpdatableInverse<typename E::value_type> updatableInverse(const MatrixExpr<E>& a) {
+    return UpdatableInverse<typename E::value_type>(solveOperand(a.self()));
+}
+
+// mixedPrecisionLU<double>(A).solve(B) solves a long double system at double speed (see MixedPrecisionLU)
+template <class Work, class E>
+MixedPrecisionLU<Work, typename E::value_type> mixedPrecisionLU(const MatrixExpr<E>& a) {
+    return MixedPrecisionLU<Work, typename E::value_type>(solveOperand(a.self()));
+}
+
+// One-off solve: square systems through LU, tall ones in the least-squares sense through QR.
+// To solve against the same A repeatedly, keep A.lu(), cholesky(A) or qr(A) and call its solve().
+template <class EA, class EB>
+BasicMatrix<typename EA::value_type> solve(const MatrixExpr<EA>& a, const MatrixExpr<EB>& b) {
+    using T = typename EA::value_type;
+    const auto& A = solveOperand(a.self());
+    const auto& B = solveOperand(b.self());
+    if (A.getRow() == A.getCol()) {
+        return LUDecomposition<T>(A).solve(B);
+    }
+    if (A.getRow() > A.getCol()) {
+        return QRDecomposition<T>(A).solve(B);
+    }
+    throw invalid_argument("solve: underdetermined systems (more columns than rows) are not supported.");
+}
+
+template <class E>
+vector<typename E::value_type> solve(const MatrixExpr<E>& a, const vector<typename E::value_type>& b) {
+    using T = typename E::value_type;
+    const auto& A = solveOperand(a.self());
+    if (A.getRow() == A.getCol()) {
+        return LUDecomposition<T>(A).solve(b);
+    }
+    if (A.getRow() > A.getCol()) {
+        return QRDecomposition<T>(A).solve(b);
+    }
+    throw invalid_argument("solve: underdetermined systems (more columns than rows) are not supported.");
+}
+
+#endif  // SOLVE_H
@@ -0,0 +1,354 @@
+#ifndef SPARSEMATRIX_H
+#define SPARSEMATRIX_H
+
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+#include <numeric>
+#include <cstddef>
+#include "Matrix.h"
+
+using namespace std;
+
+// Compressed sparse matrix in CSR (row-major) or CSC (column-major) layout.
+// "Major" means rows for CSR and columns for CSC: ptr[m]..ptr[m + 1] is the range of idx/val holding
+// major line m, idx are the minor indices (sorted, no duplicates) and val the matching nonzeros.
+// Memory is O(nnz + major) instead of O(rows * cols).
+
+enum class SparseFormat { CSR, CSC };
+
+// One COO entry for the bulk builders
+template <class T>
+struct Triplet {
+    int row, col;
+    T value;
+};
+
+template <class T>
+class BasicSparseMatrix {
+public:
+    BasicSparseMatrix() : row(0), col(0), fmt(SparseFormat::CSR), ptr(1, 0) {}
+
+    // All-zero rows x cols matrix
+    BasicSparseMatrix(int rows, int cols, SparseFormat format = SparseFormat::CSR) : row(rows), col(cols), fmt(format) {
+        if (rows <= 0 || cols <= 0) {
+            throw invalid_argument("Matrix dimensions must be positive integers.");
+        }
+        ptr.assign(static_cast<size_t>(majorCount()) + 1, 0);
+    }
+
+    // Bulk COO build in O(nnz + major): a counting sort by major index, then each major line is
+    // sorted by minor index (in parallel) and duplicate entries are summed.
+    static BasicSparseMatrix fromTriplets(int rows, int cols, const vector<Triplet<T>>& entries,
+                                          SparseFormat format = SparseFormat::CSR) {
+        BasicSparseMatrix s(rows, cols, format);
+        const bool csr = format == SparseFormat::CSR;
+        for (const Triplet<T>& e : entries) {
+            if (e.row < 0 || e.row >= rows || e.col < 0 || e.col >= cols) {
+                throw runtime_error("Index out of bounds!");
+            }
+            s.ptr[(csr ? e.row : e.col) + 1]++;
+        }
+        partial_sum(s.ptr.begin(), s.ptr.end(), s.ptr.begin());
+
+        vector<size_t> next(s.ptr.begin(), s.ptr.end() - 1);
+        vector<int> idx(entries.size());
+        vector<T> val(entries.size());
+        for (const Triplet<T>& e : entries) {
+            const size_t k = next[csr ? e.row : e.col]++;
+            idx[k] = csr ? e.col : e.row;
+            val[k] = e.value;
+        }
+        s.idx.swap(idx);
+        s.val.swap(val);
+        s.sortAndCombine();
+        return s;
+    }
+
+    // Entries with |a_ij| <= dropTolerance are left out
+    static BasicSparseMatrix fromDense(const BasicMatrix<T>& a, T dropTolerance = 0,
+                                       SparseFormat format = SparseFormat::CSR) {
+        BasicSparseMatrix s(a.getRow(), a.getCol(), SparseFormat::CSR);
+        for (int i = 0; i < a.getRow(); i++) {
+            const T* ai = a.data() + static_cast<size_t>(i) * a.getLd();
+            for (int j = 0; j < a.getCol(); j++) {
+                if (fabs(ai[j]) > dropTolerance) {
+                    s.idx.push_back(j);
+                    s.val.push_back(ai[j]);
+                }
+            }
+            s.ptr[i + 1] = s.idx.size();
+        }
+        return format == SparseFormat::CSR ? s : s.toCSC();
+    }
+
+    BasicMatrix<T> toDense() const {
+        BasicMatrix<T> d(row, col);
+        T* p = d.data();
+        const bool csr = fmt == SparseFormat::CSR;
+        for (int m = 0; m < majorCount(); m++) {
+            for (size_t k = ptr[m]; k < ptr[m + 1]; k++) {
+                const size_t i = csr ? m : idx[k];
+                const size_t j = csr ? idx[k] : m;
+                p[i * col + j] = val[k];
+            }
+        }
+        return d;
+    }
+
+    BasicSparseMatrix toCSR() const { return fmt == SparseFormat::CSR ? *this : convert(); }
+    BasicSparseMatrix toCSC() const { return fmt == SparseFormat::CSC ? *this : convert(); }
+
+    // A^T shares the arrays: CSR of A read as CSC is A^T, so no entries move
+    BasicSparseMatrix transpose() const {
+        BasicSparseMatrix t(*this);
+        swap(t.row, t.col);
+        t.fmt = fmt == SparseFormat::CSR ? SparseFormat::CSC : SparseFormat::CSR;
+        return t;
+    }
+
+    // Binary search within the major line; zero when the entry is not stored
+    T getElementAt(int i, int j) const {
+        if (i < 0 || i >= row || j < 0 || j >= col) {
+            throw runtime_error("Index out of bounds!");
+        }
+        const int m = fmt == SparseFormat::CSR ? i : j;
+        const int minor = fmt == SparseFormat::CSR ? j : i;
+        const auto first = idx.begin() + ptr[m];
+        const auto last = idx.begin() + ptr[m + 1];
+        const auto it = lower_bound(first, last, minor);
+        return it != last && *it == minor ? val[it - idx.begin()] : T(0);
+    }
+
+    // y = A * x. CSR splits the rows into ranges of equal nonzero count; CSC scatters column
+    // ranges into one private y per thread and sums them.
+    vector<T> multiply(const vector<T>& x) const {
+        if (static_cast<int>(x.size()) != col) {
+            throw runtime_error("Matrix dimensions do not match for multiplication!");
+        }
+        vector<T> y(row, T(0));
+        const T* xv = x.data();
+        T* yv = y.data();
+        // CSC keeps one y per part, so it uses no more parts than threads
+        const size_t parts = fmt == SparseFormat::CSR ? partCount() : min<size_t>(partCount(), getNumThreads());
+        const vector<int> bounds = balancedMajorRanges(parts);
+
+        if (fmt == SparseFormat::CSR) {
+            parallelFor(0, parts, nnz() / parts, [&](size_t lo, size_t hi) {
+                for (int i = bounds[lo]; i < bounds[hi]; i++) {
+                    T sum = 0;
+                    for (size_t k = ptr[i]; k < ptr[i + 1]; k++) sum += val[k] * xv[idx[k]];
+                    yv[i] = sum;
+                }
+            });
+            return y;
+        }
+
+        vector<T> partial(parts > 1 ? (parts - 1) * static_cast<size_t>(row) : 0, T(0));
+        parallelFor(0, parts, nnz() / parts, [&](size_t lo, size_t hi) {
+            for (size_t part = lo; part < hi; part++) {
+                T* out = part == 0 ? yv : partial.data() + (part - 1) * row;
+                for (int j = bounds[part]; j < bounds[part + 1]; j++) {
+                    const T xj = xv[j];
+                    for (size_t k = ptr[j]; k < ptr[j + 1]; k++) out[idx[k]] += val[k] * xj;
+                }
+            }
+        });
+        if (parts > 1) {
+            parallelFor(0, row, parts, [&](size_t lo, size_t hi) {
+                for (size_t part = 1; part < parts; part++) {
+                    const T* in = partial.data() + (part - 1) * row;
+                    for (size_t i = lo; i < hi; i++) yv[i] += in[i];
+                }
+            });
+        }
+        return y;
+    }
+
+    // C = A * B with dense B and C. CSR: row i of C accumulates scaled rows of B (contiguous and
+    // vectorizable), rows split by nonzero count. CSC: threads own disjoint column ranges of C.
+    BasicMatrix<T> multiply(const BasicMatrix<T>& B) const {
+        if (col != B.getRow()) {
+            throw runtime_error("Matrix dimensions do not match for multiplication!");
+        }
+        const int n = B.getCol();
+        BasicMatrix<T> C(row, n);
+        const T* b = B.data();
+        const size_t ldb = B.getLd();
+        T* c = C.data();
+
+        if (fmt == SparseFormat::CSR) {
+            const size_t parts = partCount();
+            const vector<int> bounds = balancedMajorRanges(parts);
+            parallelFor(0, parts, nnz() / parts * n, [&](size_t lo, size_t hi) {
+                for (int i = bounds[lo]; i < bounds[hi]; i++) {
+                    T* ci = c + static_cast<size_t>(i) * n;
+                    for (size_t k = ptr[i]; k < ptr[i + 1]; k++) {
+                        const T a = val[k];
+                        const T* bk = b + static_cast<size_t>(idx[k]) * ldb;
+                        for (int j = 0; j < n; j++) ci[j] += a * bk[j];
+                    }
+                }
+            });
+            return C;
+        }
+
+        parallelFor(0, n, nnz(), [&](size_t lo, size_t hi) {
+            for (int j = 0; j < col; j++) {
+                const T* bj = b + static_cast<size_t>(j) * ldb;
+                for (size_t k = ptr[j]; k < ptr[j + 1]; k++) {
+                    const T a = val[k];
+                    T* ci = c + static_cast<size_t>(idx[k]) * n;
+                    for (size_t q = lo; q < hi; q++) ci[q] += a * bj[q];
+                }
+            }
+        });
+        return C;
+    }
+
+    int getRow() const { return row; }
+    int getCol() const { return col; }
+    size_t nnz() const { return val.size(); }
+    SparseFormat format() const { return fmt; }
+
+    // Raw compressed arrays, e.g. for handing the matrix to another library
+    const vector<size_t>& getPointers() const { return ptr; }
+    const vector<int>& getIndices() const { return idx; }
+    const vector<T>& getValues() const { return val; }
+
+private:
+    int row, col;
+    SparseFormat fmt;
+    vector<size_t> ptr;   // majorCount() + 1 offsets into idx/val
+    vector<int> idx;
+    vector<T> val;
+
+    int majorCount() const { return fmt == SparseFormat::CSR ? row : col; }
+
+    // Tasks for the parallel kernels: about four per thread, fewer for small matrices
+    size_t partCount() const {
+        const size_t byWork = max<size_t>(1, nnz() / getParallelGrain());
+        return max<size_t>(1, min({static_cast<size_t>(4 * getNumThreads()), byWork, static_cast<size_t>(majorCount())}));
+    }
+
+    // parts + 1 major-line boundaries such that every range holds about nnz() / parts entries
+    vector<int> balancedMajorRanges(size_t parts) const {
+        vector<int> bounds(parts + 1, majorCount());
+        bounds[0] = 0;
+        for (size_t p = 1; p < parts; p++) {
+            const size_t target = nnz() * p / parts;
+            bounds[p] = static_cast<int>(upper_bound(ptr.begin(), ptr.end(), target) - ptr.begin()) - 1;
+            bounds[p] = max(bounds[p], bounds[p - 1]);
+        }
+        return bounds;
+    }
+
+    // Sort every major line by minor index and merge duplicates, then compact the arrays
+    void sortAndCombine() {
+        const int majors = majorCount();
+        vector<size_t> kept(static_cast<size_t>(majors) + 1, 0);
+        parallelFor(0, majors, max<size_t>(1, nnz() / max(majors, 1)) * 8, [&](size_t lo, size_t hi) {
+            vector<pair<int, T>> line;
+            for (size_t m = lo; m < hi; m++) {
+                const size_t b = ptr[m], e = ptr[m + 1];
+                bool sorted = true;
+                for (size_t k = b + 1; k < e && sorted; k++) sorted = idx[k - 1] < idx[k];
+                if (sorted) {
+                    kept[m + 1] = e - b;
+                    continue;
+                }
+                line.clear();
+                for (size_t k = b; k < e; k++) line.emplace_back(idx[k], val[k]);
+                stable_sort(line.begin(), line.end(), [](const pair<int, T>& x, const pair<int, T>& y) { return x.first < y.first; });
+                size_t out = b;
+                for (size_t k = 0; k < line.size(); k++) {
+                    if (out > b && idx[out - 1] == line[k].first) {
+                        val[out - 1] += line[k].second;
+                    } else {
+                        idx[out] = line[k].first;
+                        val[out] = line[k].second;
+                        out++;
+                    }
+                }
+                kept[m + 1] = out - b;
+            }
+        });
+        partial_sum(kept.begin(), kept.end(), kept.begin());
+        if (kept[majors] != nnz()) {
+            for (int m = 0; m < majors; m++) {
+                move(idx.begin() + ptr[m], idx.begin() + ptr[m] + (kept[m + 1] - kept[m]), idx.begin() + kept[m]);
+                move(val.begin() + ptr[m], val.begin() + ptr[m] + (kept[m + 1] - kept[m]), val.begin() + kept[m]);
+            }
+            idx.resize(kept[majors]);
+            val.resize(kept[majors]);
+        }
+        ptr.swap(kept);
+    }
+
+    // CSR <-> CSC with one counting pass; scanning major lines in order keeps the new lines sorted
+    BasicSparseMatrix convert() const {
+        BasicSparseMatrix out(row, col, fmt == SparseFormat::CSR ? SparseFormat::CSC : SparseFormat::CSR);
+        for (size_t k = 0; k < nnz(); k++) out.ptr[idx[k] + 1]++;
+        partial_sum(out.ptr.begin(), out.ptr.end(), out.ptr.begin());
+        out.idx.resize(nnz());
+        out.val.resize(nnz());
+        vector<size_t> next(out.ptr.begin(), out.ptr.end() - 1);
+        for (int m = 0; m < majorCount(); m++) {
+            for (size_t k = ptr[m]; k < ptr[m + 1]; k++) {
+                const size_t dst = next[idx[k]]++;
+                out.idx[dst] = m;
+                out.val[dst] = val[k];
+            }
+        }
+        return out;
+    }
+};
+
+// Accumulates COO entries (one at a time or in bulk) and compresses them once in build().
+// Duplicate (row, col) entries are summed, as in finite-element assembly.
+template <class T>
+class SparseBuilder {
+public:
+    SparseBuilder(int rows, int cols) : row(rows), col(cols) {}
+
+    void reserve(size_t entries) { entries_.reserve(entries); }
+
+    void add(int i, int j, T value) { entries_.push_back(Triplet<T>{i, j, value}); }
+
+    void add(const vector<Triplet<T>>& entries) { entries_.insert(entries_.end(), entries.begin(), entries.end()); }
+
+    // Parallel arrays of row indices, column indices and values
+    void add(const vector<int>& rows, const vector<int>& cols, const vector<T>& values) {
+        if (rows.size() != cols.size() || rows.size() != values.size()) {
+            throw invalid_argument("SparseBuilder: row, column and value arrays must have the same length.");
+        }
+        entries_.reserve(entries_.size() + rows.size());
+        for (size_t k = 0; k < rows.size(); k++) entries_.push_back(Triplet<T>{rows[k], cols[k], values[k]});
+    }
+
+    size_t size() const { return entries_.size(); }
+
+    BasicSparseMatrix<T> build(SparseFormat format = SparseFormat::CSR) const {
+        return BasicSparseMatrix<T>::fromTriplets(row, col, entries_, format);
+    }
+
+private:
+    int row, col;
+    vector<Triplet<T>> entries_;
+};
+
+template <class T>
+vector<T> operator*(const BasicSparseMatrix<T>& a, const vector<T>& x) {
+    return a.multiply(x);
+}
+
+template <class T>
+BasicMatrix<T> operator*(const BasicSparseMatrix<T>& a, const BasicMatrix<T>& b) {
+    return a.multiply(b);
+}
+
+using SparseMatrix  = BasicSparseMatrix<long double>;
+using SparseMatrixD = BasicSparseMatrix<double>;
+using SparseMatrixF = BasicSparseMatrix<float>;
+
+#endif  // SPARSEMATRIX_H
@@ -0,0 +1,636 @@
+#ifndef SPECTRAL_H
+#define SPECTRAL_H
+
+#include <vector>
+#include <stdexcept>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <numeric>
+#include <memory>
+#include "Matrix.h"
+#include "Solve.h"
+
+using namespace std;
+
+// Spectral decompositions: eigenpairs of symmetric matrices and the singular value decomposition.
+// Values come sorted from largest to smallest, vectors are the matching columns.
+
+namespace spectral_detail {
+
+// Reflectors per block when Q is applied with GEMM
+constexpr int reflectorBlock = 32;
+
+// Householder reduction of a symmetric matrix to tridiagonal form, Q^T * A * Q = tridiag(e, d, e).
+// Each step is a symmetric matrix-vector product and a rank-2 update of the trailing matrix, both split
+// across threads by rows. Reflector k acts on rows k+1.. and its vector (unit first entry implied) is
+// left in a[k+2:, k]; d is the diagonal, e[k] couples k and k+1.
+template <class T>
+void tridiagonalize(BasicMatrix<T>& mat, vector<T>& d, vector<T>& e, vector<T>& tau) {
+    const int n = mat.getRow();
+    T* a = mat.data();
+    d.assign(n, T(0));
+    e.assign(n, T(0));
+    tau.assign(max(n - 2, 0), T(0));
+    vector<T> v(n), p(n), w(n);
+
+    for (int k = 0; k + 2 < n; k++) {
+        const int m = n - k - 1;
+        T* col = a + static_cast<size_t>(k + 1) * n + k;  // a[k+1+i][k] = col[i * n]
+        const T alpha = col[0];
+        T sigma = 0;
+        for (int i = 1; i < m; i++) sigma += col[i * n] * col[i * n];
+        d[k] = a[static_cast<size_t>(k) * n + k];
+        if (sigma == 0) {
+            e[k] = alpha;
+            continue;
+        }
+        const T norm = sqrt(alpha * alpha + sigma);
+        const T beta = alpha <= 0 ? norm : -norm;
+        const T t = (beta - alpha) / beta;
+        const T scale = T(1) / (alpha - beta);
+        v[0] = 1;
+        for (int i = 1; i < m; i++) {
+            v[i] = col[i * n] * scale;
+            col[i * n] = v[i];
+        }
+        e[k] = beta;
+        tau[k] = t;
+
+        // p = tau * A22 * v, w = p - (tau / 2) (p . v) v, A22 -= v w^T + w v^T
+        T* a22 = a + static_cast<size_t>(k + 1) * n + k + 1;
+        const T* vp = v.data();
+        T* pp = p.data();
+        parallelFor(0, m, m, [=](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; i++) pp[i] = t * trsm_detail::dot(a22 + i * n, vp, m);
+        });
+        const T K = t / 2 * trsm_detail::dot(pp, vp, m);
+        for (int i = 0; i < m; i++) w[i] = p[i] - K * v[i];
+        const T* wp = w.data();
+        parallelFor(0, m, 2 * m, [=](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; i++) {
+                T* ri = a22 + i * n;
+                const T vi = vp[i], wi = wp[i];
+                for (int j = 0; j < m; j++) ri[j] -= vi * wp[j] + wi * vp[j];
+            }
+        });
+    }
+    if (n >= 2) {
+        d[n - 2] = a[static_cast<size_t>(n - 2) * n + n - 2];
+        e[n - 2] = a[static_cast<size_t>(n - 1) * n + n - 2];
+    }
+    if (n >= 1) d[n - 1] = a[static_cast<size_t>(n) * n - 1];
+}
+
+// Z = Q * Z for the Q of tridiagonalize(), blocks of reflectors applied last to first with GEMM
+template <class T>
+void applyTridiagonalQ(const BasicMatrix<T>& reduced, const vector<T>& tau, BasicMatrix<T>& z) {
+    const int n = reduced.getRow();
+    const int count = static_cast<int>(tau.size());
+    const int blocks = (count + reflectorBlock - 1) / reflectorBlock;
+    const T* a = reduced.data();
+    vector<T> t(reflectorBlock * reflectorBlock);
+    for (int b = blocks - 1; b >= 0; b--) {
+        const int k0 = b * reflectorBlock;
+        const int kb = min(reflectorBlock, count - k0);
+        const int mk = n - k0 - 1;
+        BasicMatrix<T> vb(mk, kb);
+        for (int r = 0; r < mk; r++) {
+            for (int c = 0; c < kb && c <= r; c++) {
+                vb(r, c) = r == c ? T(1) : a[static_cast<size_t>(k0 + 1 + r) * n + k0 + c];
+            }
+        }
+        fill(t.begin(), t.end(), T(0));
+        householder_detail::formT(mk, kb, vb.data(), kb, tau.data() + k0, t.data(), reflectorBlock);
+        householder_detail::applyBlockReflector(mk, kb, vb.data(), kb, t.data(), reflectorBlock,
+                                                z.data() + static_cast<size_t>(k0 + 1) * z.getCol(), z.getCol(),
+                                                z.getCol(), false);
+    }
+}
+
+// Implicit QL with Wilkinson shifts on the tridiagonal (d, e) (EISPACK tql2). On return d holds the
+// eigenvalues in no particular order. With zt (n x n, initially I) the rotations of every QL sweep are
+// recorded and then applied to zt, giving the tridiagonal's eigenvectors as its rows: a rotation then
+// combines two contiguous rows, which vectorizes, and threads take disjoint column ranges.
+template <class T>
+void tridiagonalQL(vector<T>& d, vector<T>& e, BasicMatrix<T>* zt) {
+    const int n = static_cast<int>(d.size());
+    const T eps = numeric_limits<T>::epsilon();
+    struct Rotation { int i; T c, s; };
+    vector<Rotation> sweep;
+    T f = 0, tst1 = 0;
+    for (int l = 0; l < n; l++) {
+        tst1 = max(tst1, static_cast<T>(fabs(d[l]) + fabs(e[l])));
+        int m = l;
+        while (m < n - 1 && fabs(e[m]) > eps * tst1) m++;
+        if (m > l) {
+            int iter = 0;
+            do {
+                if (++iter > 60) {
+                    throw runtime_error("Eigenvalue iteration did not converge!");
+                }
+                T g = d[l];
+                T p = (d[l + 1] - g) / (2 * e[l]);
+                T r = hypot(p, T(1));
+                if (p < 0) r = -r;
+                d[l] = e[l] / (p + r);
+                d[l + 1] = e[l] * (p + r);
+                const T dl1 = d[l + 1];
+                T h = g - d[l];
+                for (int i = l + 2; i < n; i++) d[i] -= h;
+                f += h;
+
+                p = d[m];
+                T c = 1, c2 = 1, c3 = 1, s = 0, s2 = 0;
+                const T el1 = e[l + 1];
+                sweep.clear();
+                for (int i = m - 1; i >= l; i--) {
+                    c3 = c2;
+                    c2 = c;
+                    s2 = s;
+                    g = c * e[i];
+                    h = c * p;
+                    r = hypot(p, e[i]);
+                    e[i + 1] = s * r;
+                    s = e[i] / r;
+                    c = p / r;
+                    p = c * d[i] - s * g;
+                    d[i + 1] = h + s * (c * g + s * d[i]);
+                    if (zt) sweep.push_back(Rotation{i, c, s});
+                }
+                p = -s * s2 * c3 * el1 * e[l] / dl1;
+                e[l] = s * p;
+                d[l] = c * p;
+
+                if (zt && !sweep.empty()) {
+                    T* zp = zt->data();
+                    const size_t zc = zt->getCol();
+                    const Rotation* rot = sweep.data();
+                    const size_t count = sweep.size();
+                    parallelFor(0, zc, 6 * count, [=](size_t lo, size_t hi) {
+                        for (size_t q = 0; q < count; q++) {
+                            T* zi = zp + rot[q].i * zc;
+                            T* zi1 = zi + zc;
+                            const T c = rot[q].c, s = rot[q].s;
+                            for (size_t k = lo; k < hi; k++) {
+                                const T a = zi[k], b = zi1[k];
+                                zi1[k] = s * a + c * b;
+                                zi[k] = c * a - s * b;
+                            }
+                        }
+                    });
+                }
+            } while (fabs(e[l]) > eps * tst1);
+        }
+        d[l] += f;
+        e[l] = 0;
+    }
+}
+
+// Number of eigenvalues of the tridiagonal (d, e) below x (Sturm sequence)
+template <class T>
+int sturmCount(const vector<T>& d, const vector<T>& e, T x, T pivmin) {
+    int count = 0;
+    T q = d[0] - x;
+    if (fabs(q) < pivmin) q = -pivmin;
+    if (q < 0) count++;
+    for (size_t i = 1; i < d.size(); i++) {
+        q = d[i] - x - e[i - 1] * e[i - 1] / q;
+        if (fabs(q) < pivmin) q = -pivmin;
+        if (q < 0) count++;
+    }
+    return count;
+}
+
+// Solve (T - lambda I) x = b for the tridiagonal (d, e), LU with partial pivoting (LAPACK gttrf/gttrs)
+template <class T>
+void shiftedTridiagonalSolve(const vector<T>& d, const vector<T>& e, T lambda, T pivmin, vector<T>& b) {
+    const int n = static_cast<int>(d.size());
+    vector<T> dl(e.begin(), e.begin() + max(n - 1, 0)), du(dl), du2(max(n - 2, 0), T(0)), dd(n);
+    vector<char> swapped(max(n - 1, 0), 0);
+    for (int i = 0; i < n; i++) dd[i] = d[i] - lambda;
+    for (int i = 0; i + 1 < n; i++) {
+        if (fabs(dd[i]) >= fabs(dl[i])) {
+            if (fabs(dd[i]) < pivmin) dd[i] = pivmin;
+            const T fact = dl[i] / dd[i];
+            dl[i] = fact;
+            dd[i + 1] -= fact * du[i];
+        } else {
+            const T fact = dd[i] / dl[i];
+            dd[i] = dl[i];
+            dl[i] = fact;
+            const T temp = du[i];
+            du[i] = dd[i + 1];
+            dd[i + 1] = temp - fact * dd[i + 1];
+            if (i + 2 < n) {
+                du2[i] = du[i + 1];
+                du[i + 1] = -fact * du[i + 1];
+            }
+            swapped[i] = 1;
+        }
+    }
+    if (fabs(dd[n - 1]) < pivmin) dd[n - 1] = pivmin;
+
+    for (int i = 0; i + 1 < n; i++) {
+        if (swapped[i]) {
+            const T temp = b[i];
+            b[i] = b[i + 1];
+            b[i + 1] = temp - dl[i] * b[i];
+        } else {
+            b[i + 1] -= dl[i] * b[i];
+        }
+    }
+    for (int i = n - 1; i >= 0; i--) {
+        T s = b[i];
+        if (i + 1 < n) s -= du[i] * b[i + 1];
+        if (i + 2 < n) s -= du2[i] * b[i + 2];
+        b[i] = s / dd[i];
+    }
+}
+
+// The k largest eigenvalues of the tridiagonal (d, e), largest first, by bisection (one per task),
+// and if z is given their eigenvectors (n x k columns) by inverse iteration. Eigenvalues closer than
+// 1e-3 * ||T|| form a cluster whose vectors are orthogonalized against each other (LAPACK stein).
+template <class T>
+void tridiagonalTopK(const vector<T>& d, const vector<T>& e, int k, vector<T>& values, BasicMatrix<T>* z) {
+    const int n = static_cast<int>(d.size());
+    const T eps = numeric_limits<T>::epsilon();
+    T lo = d[0], hi = d[0], norm = 0, maxE2 = 1;
+    for (int i = 0; i < n; i++) {
+        const T radius = (i > 0 ? fabs(e[i - 1]) : T(0)) + (i + 1 < n ? fabs(e[i]) : T(0));
+        lo = min(lo, d[i] - radius);
+        hi = max(hi, d[i] + radius);
+        norm = max(norm, static_cast<T>(fabs(d[i]) + radius));
+        if (i + 1 < n) maxE2 = max(maxE2, e[i] * e[i]);
+    }
+    const T pivmin = numeric_limits<T>::min() * maxE2;
+    const T pad = 2 * eps * norm + pivmin;
+    lo -= pad;
+    hi += pad;
+
+    values.assign(k, T(0));
+    parallelFor(0, k, 64 * static_cast<size_t>(n), [&](size_t first, size_t last) {
+        for (size_t r = first; r < last; r++) {
+            const int index = n - 1 - static_cast<int>(r);  // ascending position of the r-th largest
+            T a = lo, b = hi;
+            while (b - a > 2 * eps * max(fabs(a), fabs(b)) + pivmin) {
+                const T mid = a + (b - a) / 2;
+                if (mid <= a || mid >= b) break;
+                if (sturmCount(d, e, mid, pivmin) <= index) a = mid;
+                else b = mid;
+            }
+            values[r] = a + (b - a) / 2;
+        }
+    });
+    if (!z) return;
+
+    // Clusters of nearby eigenvalues share an orthogonalization; different clusters run in parallel
+    vector<int> clusterStart(1, 0);
+    for (int r = 1; r < k; r++) {
+        if (values[r - 1] - values[r] > T(1e-3) * norm) clusterStart.push_back(r);
+    }
+    clusterStart.push_back(k);
+    *z = BasicMatrix<T>(n, k);
+    T* zp = z->data();
+    parallelFor(0, clusterStart.size() - 1, 5 * static_cast<size_t>(n), [&](size_t first, size_t last) {
+        vector<vector<T>> cluster;
+        vector<T> x(n);
+        for (size_t c = first; c < last; c++) {
+            cluster.clear();
+            T shift = 0;
+            for (int r = clusterStart[c]; r < clusterStart[c + 1]; r++) {
+                // Equal eigenvalues are separated slightly so each solve has a distinct shift
+                T lambda = values[r];
+                if (r > clusterStart[c] && shift - lambda < 10 * eps * fabs(lambda)) {
+                    lambda = shift - 10 * eps * max(fabs(lambda), norm * eps);
+                }
+                shift = lambda;
+                unsigned seed = 12345u + 7919u * r;
+                for (int i = 0; i < n; i++) {
+                    seed = seed * 1103515245u + 12345u;
+                    x[i] = T(1) + T((seed >> 16) & 0x7fff) / T(32768);
+                }
+                for (int it = 0; it < 4; it++) {
+                    shiftedTridiagonalSolve(d, e, lambda, pivmin, x);
+                    for (const vector<T>& y : cluster) {
+                        const T proj = trsm_detail::dot(x.data(), y.data(), n);
+                        for (int i = 0; i < n; i++) x[i] -= proj * y[i];
+                    }
+                    const T len = sqrt(trsm_detail::dot(x.data(), x.data(), n));
+                    for (int i = 0; i < n; i++) x[i] /= len;
+                }
+                cluster.push_back(x);
+                for (int i = 0; i < n; i++) zp[static_cast<size_t>(i) * k + r] = x[i];
+            }
+        }
+    });
+}
+
+// One-sided Jacobi: rotate pairs of rows of w (r x len) until they are mutually orthogonal, applying
+// the same rotations to the rows of vt if given. Each round pairs every row once (round-robin
+// tournament), so the rotations of a round touch disjoint rows and run in parallel.
+template <class T>
+void jacobiOrthogonalize(BasicMatrix<T>& w, BasicMatrix<T>* vt) {
+    const int r = w.getRow(), len = w.getCol();
+    if (r < 2) return;
+    const int players = r + (r % 2);
+    const T tol = numeric_limits<T>::epsilon() * sqrt(static_cast<T>(len));
+    T* wp = w.data();
+    T* vp = vt ? vt->data() : nullptr;
+    const int vlen = vt ? vt->getCol() : 0;
+
+    // Squared row norms are carried along (a rotation changes them by -+ t * gamma) and
+    // recomputed every sweep, so each pair costs one dot product instead of three
+    vector<T> norm2(r);
+    for (int sweep = 0; ; sweep++) {
+        if (sweep == 60) {
+            throw runtime_error("SVD iteration did not converge!");
+        }
+        for (int i = 0; i < r; i++) {
+            const T* x = wp + static_cast<size_t>(i) * len;
+            norm2[i] = trsm_detail::dot(x, x, len);
+        }
+        vector<char> rotated(players / 2, 0);
+        for (int round = 0; round < players - 1; round++) {
+            parallelFor(0, players / 2, 6 * static_cast<size_t>(len + vlen), [&](size_t lo, size_t hi) {
+                for (size_t pair = lo; pair < hi; pair++) {
+                    const int i = static_cast<int>(pair);
+                    int p = i == 0 ? 0 : (i - 1 + round) % (players - 1) + 1;
+                    int q = (players - 2 - i + round) % (players - 1) + 1;
+                    if (p >= r || q >= r) continue;
+                    if (p > q) swap(p, q);
+                    T* x = wp + static_cast<size_t>(p) * len;
+                    T* y = wp + static_cast<size_t>(q) * len;
+                    const T alpha = norm2[p];
+                    const T beta = norm2[q];
+                    if (alpha == 0 || beta == 0) continue;
+                    const T gamma = trsm_detail::dot(x, y, len);
+                    if (fabs(gamma) <= tol * sqrt(alpha * beta)) continue;
+                    rotated[pair] = 1;
+                    const T zeta = (beta - alpha) / (2 * gamma);
+                    const T t = (zeta >= 0 ? T(1) : T(-1)) / (fabs(zeta) + sqrt(1 + zeta * zeta));
+                    const T c = 1 / sqrt(1 + t * t);
+                    const T s = c * t;
+                    norm2[p] = alpha - t * gamma;
+                    norm2[q] = beta + t * gamma;
+                    for (int j = 0; j < len; j++) {
+                        const T xj = x[j], yj = y[j];
+                        x[j] = c * xj - s * yj;
+                        y[j] = s * xj + c * yj;
+                    }
+                    if (vp) {
+                        T* vx = vp + static_cast<size_t>(p) * vlen;
+                        T* vy = vp + static_cast<size_t>(q) * vlen;
+                        for (int j = 0; j < vlen; j++) {
+                            const T xj = vx[j], yj = vy[j];
+                            vx[j] = c * xj - s * yj;
+                            vy[j] = s * xj + c * yj;
+                        }
+                    }
+                }
+            });
+        }
+        if (find(rotated.begin(), rotated.end(), 1) == rotated.end()) break;
+    }
+}
+
+}  // namespace spectral_detail
+
+// Eigenvalues and eigenvectors of a symmetric matrix: A = V * diag(values) * V^T.
+// Only the lower triangle of A is read. Householder tridiagonalization first, then either
+// implicit QL for the whole spectrum or, when only the k largest are wanted, bisection and
+// inverse iteration on the tridiagonal; eigenvectors are mapped back with blocked (GEMM) reflectors.
+template <class T>
+class SymmetricEigen {
+public:
+    // Every eigenpair (eigenvalues only when computeVectors is false)
+    explicit SymmetricEigen(const BasicMatrix<T>& a, bool computeVectors = true) {
+        compute(a, a.getRow(), computeVectors);
+    }
+
+    // Only the k largest eigenpairs: O(n^2 k) after the reduction instead of O(n^3). A named factory
+    // rather than a constructor, so that SymmetricEigen(a, 1) cannot mean k = 1 instead of true.
+    static SymmetricEigen largest(const BasicMatrix<T>& a, int k, bool computeVectors = true) {
+        return SymmetricEigen(Largest(), a, k, computeVectors);
+    }
+
+    // Largest first
+    const vector<T>& eigenvalues() const { return values; }
+
+    // Column j belongs to eigenvalues()[j]
+    const BasicMatrix<T>& eigenvectors() const {
+        if (!hasVectors) {
+            throw runtime_error("Eigenvectors were not computed!");
+        }
+        return vectors;
+    }
+
+private:
+    vector<T> values;
+    BasicMatrix<T> vectors;
+    bool hasVectors = false;
+
+    struct Largest {};
+
+    SymmetricEigen(Largest, const BasicMatrix<T>& a, int k, bool computeVectors) {
+        if (k < 0 || k > a.getRow()) {
+            throw invalid_argument("SymmetricEigen: k must be between 0 and the matrix size.");
+        }
+        compute(a, k, computeVectors);
+    }
+
+    void compute(const BasicMatrix<T>& a, int k, bool computeVectors) {
+        using namespace spectral_detail;
+        if (a.getRow() != a.getCol()) {
+            throw invalid_argument("Eigen decomposition requires a square matrix.");
+        }
+        const int n = a.getRow();
+        hasVectors = computeVectors;
+        if (k == 0) return;
+
+        // Mirror the lower triangle so the reduction can use full rows
+        BasicMatrix<T> reduced(a);
+        for (int i = 0; i < n; i++) {
+            for (int j = i + 1; j < n; j++) reduced(i, j) = reduced(j, i);
+        }
+        vector<T> d, e, tau;
+        tridiagonalize(reduced, d, e, tau);
+
+        BasicMatrix<T> z;
+        if (k < n) {
+            tridiagonalTopK(d, e, k, values, computeVectors ? &z : nullptr);
+        } else {
+            BasicMatrix<T> zt;
+            if (computeVectors) {
+                zt = BasicMatrix<T>(n, n);
+                zt.identity();
+            }
+            tridiagonalQL(d, e, computeVectors ? &zt : nullptr);
+            vector<int> order(n);
+            iota(order.begin(), order.end(), 0);
+            sort(order.begin(), order.end(), [&](int x, int y) { return d[x] > d[y]; });
+            values.resize(n);
+            for (int i = 0; i < n; i++) values[i] = d[order[i]];
+            if (computeVectors) {
+                // Sort the rows of zt, then one tiled transpose turns them into columns
+                BasicMatrix<T> sorted(n, n);
+                for (int i = 0; i < n; i++) {
+                    copy(zt.data() + static_cast<size_t>(order[i]) * n, zt.data() + static_cast<size_t>(order[i] + 1) * n,
+                         sorted.data() + static_cast<size_t>(i) * n);
+                }
+                z = sorted.transpose();
+            }
+        }
+        if (computeVectors) {
+            applyTridiagonalQ(reduced, tau, z);
+            vectors = std::move(z);
+        }
+    }
+};
+
+// Thin singular value decomposition A = U * diag(values) * V^T of an m x n matrix, r = min(m, n):
+// U is m x r and V is n x r, both with orthonormal columns (a column whose singular value is exactly
+// zero is left zero). Tall inputs are first reduced with the blocked QR, then the r x r triangle is
+// diagonalized by parallel one-sided Jacobi, started from the eigenvectors of its Gram matrix.
+// SVD::largest(a, k) instead takes the k largest eigenpairs of the Gram matrix (A^T A or A A^T, one GEMM):
+// much faster for k << r, at the price of relative accuracy for singular values near sqrt(eps) * ||A||.
+template <class T>
+class SVD {
+public:
+    explicit SVD(const BasicMatrix<T>& a, bool computeVectors = true)
+        : rows(a.getRow()), cols(a.getCol()), hasVectors(computeVectors) {
+        if (a.getRow() >= a.getCol()) {
+            computeTall(a);
+        } else {
+            computeTall(a.transpose());
+            swap(u, v);
+        }
+    }
+
+    // Only the k largest singular triplets (a factory for the same reason as SymmetricEigen::largest)
+    static SVD largest(const BasicMatrix<T>& a, int k, bool computeVectors = true) {
+        return SVD(Largest(), a, k, computeVectors);
+    }
+
+    // Largest first
+    const vector<T>& singularValues() const { return values; }
+
+    const BasicMatrix<T>& getU() const {
+        if (!hasVectors) throw runtime_error("Singular vectors were not computed!");
+        return u;
+    }
+
+    const BasicMatrix<T>& getV() const {
+        if (!hasVectors) throw runtime_error("Singular vectors were not computed!");
+        return v;
+    }
+
+    // Singular values above tol; by default max(m, n) * eps * largest singular value
+    int rank(T tol = -1) const {
+        if (values.empty()) return 0;
+        if (tol < 0) tol = max(rows, cols) * numeric_limits<T>::epsilon() * values[0];
+        return static_cast<int>(count_if(values.begin(), values.end(), [tol](T s) { return s > tol; }));
+    }
+
+private:
+    vector<T> values;
+    BasicMatrix<T> u, v;
+    int rows, cols;
+    bool hasVectors;
+
+    struct Largest {};
+
+    SVD(Largest, const BasicMatrix<T>& a, int k, bool computeVectors)
+        : rows(a.getRow()), cols(a.getCol()), hasVectors(computeVectors) {
+        const int m = a.getRow(), n = a.getCol();
+        if (k < 0 || k > min(m, n)) {
+            throw invalid_argument("SVD: k must be between 0 and min(rows, cols).");
+        }
+        if (k == 0) return;
+        const bool tall = m >= n;
+        BasicMatrix<T> gram = tall ? BasicMatrix<T>(a.transposeView() * a) : BasicMatrix<T>(a * a.transposeView());
+        const SymmetricEigen<T> eig = SymmetricEigen<T>::largest(gram, k, computeVectors);
+        values.resize(k);
+        for (int j = 0; j < k; j++) values[j] = sqrt(max(eig.eigenvalues()[j], T(0)));
+        if (!computeVectors) return;
+
+        // The other side's vectors: U = A V / sigma (or V = A^T U / sigma)
+        const BasicMatrix<T>& known = eig.eigenvectors();
+        BasicMatrix<T> other = tall ? BasicMatrix<T>(a * known) : BasicMatrix<T>(a.transposeView() * known);
+        for (int i = 0; i < other.getRow(); i++) {
+            for (int j = 0; j < k; j++) other(i, j) = values[j] > 0 ? other(i, j) / values[j] : T(0);
+        }
+        u = tall ? std::move(other) : known;
+        v = tall ? known : std::move(other);
+    }
+
+    void computeTall(const BasicMatrix<T>& a) {
+        using namespace spectral_detail;
+        const int m = a.getRow(), n = a.getCol();
+
+        // Rows of w are the columns being orthogonalized: R^T after a QR of tall A, A^T when square
+        const bool useQR = m > n;
+        unique_ptr<QRDecomposition<T>> factor;
+        BasicMatrix<T> w;
+        if (useQR) {
+            factor.reset(new QRDecomposition<T>(a));
+            w = factor->getR().transpose();
+        } else {
+            w = a.transpose();
+        }
+        // Precondition with the eigenvectors V0 of the Gram matrix w * w^T: the columns of A * V0 are
+        // already nearly orthogonal, so Jacobi needs a sweep or two instead of a dozen
+        BasicMatrix<T> gram = w * w.transposeView();
+        BasicMatrix<T> vt = SymmetricEigen<T>(gram).eigenvectors().transpose();
+        w = vt * w;
+        jacobiOrthogonalize(w, hasVectors ? &vt : nullptr);
+
+        vector<T> norms(n);
+        for (int j = 0; j < n; j++) norms[j] = sqrt(trsm_detail::dot(w.data() + static_cast<size_t>(j) * n, w.data() + static_cast<size_t>(j) * n, n));
+        vector<int> order(n);
+        iota(order.begin(), order.end(), 0);
+        sort(order.begin(), order.end(), [&](int x, int y) { return norms[x] > norms[y]; });
+        values.resize(n);
+        for (int j = 0; j < n; j++) values[j] = norms[order[j]];
+
+        if (hasVectors) {
+            // Column j of U is row order[j] of w normalized; column j of V is row order[j] of vt
+            BasicMatrix<T> ur(useQR ? m : n, n);
+            v = BasicMatrix<T>(n, n);
+            for (int j = 0; j < n; j++) {
+                const T* wr = w.data() + static_cast<size_t>(order[j]) * n;
+                const T* vr = vt.data() + static_cast<size_t>(order[j]) * n;
+                const T inv = values[j] > 0 ? T(1) / values[j] : T(0);
+                for (int i = 0; i < n; i++) {
+                    ur(i, j) = wr[i] * inv;
+                    v(i, j) = vr[i];
+                }
+            }
+            if (useQR) factor->applyQ(ur);
+            u = std::move(ur);
+        }
+    }
+};
+
+// Free-function forms; like solve(), they accept views and other expressions
+template <class E>
+SymmetricEigen<typename E::value_type> eigenSymmetric(const MatrixExpr<E>& a, bool computeVectors = true) {
+    return SymmetricEigen<typename E::value_type>(solveOperand(a.self()), computeVectors);
+}
+
+template <class E>
+SymmetricEigen<typename E::value_type> eigenSymmetricLargest(const MatrixExpr<E>& a, int k, bool computeVectors = true) {
+    return SymmetricEigen<typename E::value_type>::largest(solveOperand(a.self()), k, computeVectors);
+}
+
+template <class E>
+SVD<typename E::value_type> svd(const MatrixExpr<E>& a, bool computeVectors = true) {
+    return SVD<typename E::value_type>(solveOperand(a.self()), computeVectors);
+}
+
+template <class E>
+SVD<typename E::value_type> svdLargest(const MatrixExpr<E>& a, int k, bool computeVectors = true) {
+    return SVD<typename E::value_type>::largest(solveOperand(a.self()), k, computeVectors);
+}
+
+#endif  // SPECTRAL_H
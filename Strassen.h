@@ -0,0 +1,238 @@
+#ifndef STRASSEN_H
+#define STRASSEN_H
+
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <algorithm>
+#include <cstddef>
+#include "Matrix.h"
+
+using namespace std;
+
+// Strassen-Winograd multiplication for very large products: 7 half-size products and 15 block
+// additions per level instead of 8 products, so the flop count grows like n^2.81. The recursion
+// stops at a crossover size (below it the blocked GEMM is faster) and whenever the workspace for
+// another level would exceed the memory budget. The seven sub-products of a level run in parallel
+// when the budget also covers their own workspace; otherwise they run one after another and the
+// blocked GEMM inside each uses the threads. Odd dimensions are peeled off and fixed up with GEMM.
+// Rounding error bounds are weaker than for the classical product (normwise rather than
+// element-wise), so this is an explicit call, not what operator* does.
+
+// Products whose smallest dimension is at most the crossover use the blocked GEMM
+inline atomic<int>& strassenCrossoverSetting() {
+    static atomic<int> crossover(1024);
+    return crossover;
+}
+
+inline void setStrassenCrossover(int n) { strassenCrossoverSetting() = max(n, 16); }
+
+inline int getStrassenCrossover() { return strassenCrossoverSetting(); }
+
+// Default workspace budget of strassenMultiply
+constexpr size_t strassenBudget = size_t(1) << 30;
+
+namespace strassen_detail {
+
+// Elements of workspace one level uses: S1..S4 (m x k halves), T1..T4 (k x n halves), P1, P6, P7
+inline size_t levelWorkspace(int m2, int n2, int k2) {
+    return 4 * static_cast<size_t>(m2) * k2 + 4 * static_cast<size_t>(k2) * n2 + 3 * static_cast<size_t>(m2) * n2;
+}
+
+// Workspace of the full recursion below an m x k times k x n product when levels run one at a time
+inline size_t sequentialWorkspace(int m, int n, int k, int crossover) {
+    size_t total = 0;
+    while (min(m, min(n, k)) > crossover) {
+        m /= 2;
+        n /= 2;
+        k /= 2;
+        total += levelWorkspace(m, n, k);
+    }
+    return total;
+}
+
+template <class T>
+StridedOperand<T> sub(const StridedOperand<T>& x, int i0, int j0, int rows, int cols) {
+    return {x.p + i0 * x.rs + j0 * x.cs, x.rs, x.cs, rows, cols};
+}
+
+// Contiguous dst = x + sign * y for same-shaped operands, rows split across threads
+template <class T>
+StridedOperand<T> combine(const StridedOperand<T>& x, const StridedOperand<T>& y, T sign, T* dst) {
+    const int rows = x.rows, cols = x.cols;
+    parallelFor(0, rows, cols, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; i++) {
+            const T* xi = x.p + static_cast<ptrdiff_t>(i) * x.rs;
+            const T* yi = y.p + static_cast<ptrdiff_t>(i) * y.rs;
+            T* d = dst + i * cols;
+            if (x.cs == 1 && y.cs == 1) {
+                for (int j = 0; j < cols; j++) d[j] = xi[j] + sign * yi[j];
+            } else {
+                for (int j = 0; j < cols; j++) d[j] = xi[j * x.cs] + sign * yi[j * y.cs];
+            }
+        }
+    });
+    return {dst, cols, 1, rows, cols};
+}
+
+// C (m x n, row stride ldc) = A * B, budget in elements
+template <class T>
+void multiply(const StridedOperand<T>& A, const StridedOperand<T>& B, T* C, ptrdiff_t ldc, size_t budget, int crossover) {
+    const int m = A.rows, n = B.cols, k = A.cols;
+    const int m2 = m / 2, n2 = n / 2, k2 = k / 2;
+    const size_t level = levelWorkspace(m2, n2, k2);
+    if (min(m, min(n, k)) <= crossover || level > budget) {
+        gemm<T>(m, n, k, T(1), A.p, A.rs, A.cs, B.p, B.rs, B.cs, T(0), C, ldc);
+        return;
+    }
+
+    vector<T> work(level);
+    T* w = work.data();
+    const size_t hA = static_cast<size_t>(m2) * k2, hB = static_cast<size_t>(k2) * n2, hC = static_cast<size_t>(m2) * n2;
+    const StridedOperand<T> A11 = sub(A, 0, 0, m2, k2), A12 = sub(A, 0, k2, m2, k2);
+    const StridedOperand<T> A21 = sub(A, m2, 0, m2, k2), A22 = sub(A, m2, k2, m2, k2);
+    const StridedOperand<T> B11 = sub(B, 0, 0, k2, n2), B12 = sub(B, 0, n2, k2, n2);
+    const StridedOperand<T> B21 = sub(B, k2, 0, k2, n2), B22 = sub(B, k2, n2, k2, n2);
+
+    // Winograd's operand sums
+    const StridedOperand<T> S1 = combine(A21, A22, T(1), w);
+    const StridedOperand<T> S2 = combine(S1, A11, T(-1), w + hA);
+    const StridedOperand<T> S3 = combine(A11, A21, T(-1), w + 2 * hA);
+    const StridedOperand<T> S4 = combine(A12, S2, T(-1), w + 3 * hA);
+    T* wb = w + 4 * hA;
+    const StridedOperand<T> T1 = combine(B12, B11, T(-1), wb);
+    const StridedOperand<T> T2 = combine(B22, T1, T(-1), wb + hB);
+    const StridedOperand<T> T3 = combine(B22, B12, T(-1), wb + 2 * hB);
+    const StridedOperand<T> T4 = combine(T2, B21, T(-1), wb + 3 * hB);
+    T* P1 = wb + 4 * hB;
+    T* P6 = P1 + hC;
+    T* P7 = P6 + hC;
+
+    // P2..P5 go straight into the quadrants of C that the final sums add them to
+    T* C11 = C;
+    T* C12 = C + n2;
+    T* C21 = C + m2 * ldc;
+    T* C22 = C21 + n2;
+    struct Product {
+        StridedOperand<T> a, b;
+        T* c;
+        ptrdiff_t ldc;
+    };
+    const Product products[7] = {
+        {A11, B11, P1, n2}, {A12, B21, C11, ldc}, {S4, B22, C12, ldc}, {A22, T4, C21, ldc},
+        {S1, T1, C22, ldc}, {S2, T2, P6, n2}, {S3, T3, P7, n2},
+    };
+    const size_t rest = budget - level;
+    const bool parallel = getNumThreads() > 1 && rest / 7 >= sequentialWorkspace(m2, n2, k2, crossover);
+    if (parallel) {
+        threadPool().parallelFor(0, 7, 1, [&](size_t lo, size_t hi) {
+            for (size_t p = lo; p < hi; p++) {
+                multiply(products[p].a, products[p].b, products[p].c, products[p].ldc, rest / 7, crossover);
+            }
+        });
+    } else {
+        for (const Product& p : products) multiply(p.a, p.b, p.c, p.ldc, rest, crossover);
+    }
+
+    // C11 = P1 + P2, C12 = P1 + P6 + P5 + P3, C21 = P1 + P6 + P7 - P4, C22 = P1 + P6 + P7 + P5 in one pass
+    parallelFor(0, m2, n2, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; i++) {
+            const T* p1 = P1 + i * n2;
+            const T* p6 = P6 + i * n2;
+            const T* p7 = P7 + i * n2;
+            T* c11 = C11 + i * ldc;
+            T* c12 = C12 + i * ldc;
+            T* c21 = C21 + i * ldc;
+            T* c22 = C22 + i * ldc;
+            for (int j = 0; j < n2; j++) {
+                const T u2 = p1[j] + p6[j];
+                const T u3 = u2 + p7[j];
+                c11[j] += p1[j];
+                c12[j] += u2 + c22[j];
+                c21[j] = u3 - c21[j];
+                c22[j] += u3;
+            }
+        }
+    });
+
+    // Peeling: the last row, column and inner index when a dimension is odd
+    const int me = 2 * m2, ne = 2 * n2, ke = 2 * k2;
+    if (ke < k) {
+        gemm<T>(me, ne, 1, T(1), A.p + ke * A.cs, A.rs, A.cs, B.p + ke * B.rs, B.rs, B.cs, T(1), C, ldc);
+    }
+    if (ne < n) {
+        gemm<T>(m, 1, k, T(1), A.p, A.rs, A.cs, B.p + ne * B.cs, B.rs, B.cs, T(0), C + ne, ldc);
+    }
+    if (me < m) {
+        gemm<T>(1, ne, k, T(1), A.p + me * A.rs, A.rs, A.cs, B.p, B.rs, B.cs, T(0), C + me * ldc, ldc);
+    }
+}
+
+}  // namespace strassen_detail
+
+// C (m x n, row stride ldc) = A (m x k) * B (k x n) by Strassen-Winograd, addressing A and B as gemm() does.
+// memoryBytes bounds the workspace of all levels together; crossover defaults to getStrassenCrossover().
+template <class T>
+void strassen(int m, int n, int k,
+              const T* A, ptrdiff_t rsA, ptrdiff_t csA,
+              const T* B, ptrdiff_t rsB, ptrdiff_t csB,
+              T* C, ptrdiff_t ldc, size_t memoryBytes = strassenBudget, int crossover = 0) {
+    if (m <= 0 || n <= 0) return;
+    strassen_detail::multiply<T>({A, rsA, csA, m, k}, {B, rsB, csB, k, n}, C, ldc, memoryBytes / sizeof(T),
+                                 crossover > 0 ? crossover : getStrassenCrossover());
+}
+
+// A * B like operator*, through strassen()
+template <class L, class R>
+BasicMatrix<typename L::value_type> strassenMultiply(const MatrixExpr<L>& l, const MatrixExpr<R>& r,
+                                                     size_t memoryBytes = strassenBudget) {
+    using T = typename L::value_type;
+    const auto& lhs = productOperand(l.self());
+    const auto& rhs = productOperand(r.self());
+    const StridedOperand<T> a = stridedOperand(lhs);
+    const StridedOperand<T> b = stridedOperand(rhs);
+    if (a.cols != b.rows) {
+        throw runtime_error("Matrix dimensions do not match for multiplication!");
+    }
+    BasicMatrix<T> result(a.rows, b.cols);
+    strassen<T>(a.rows, b.cols, a.cols, a.p, a.rs, a.cs, b.p, b.rs, b.cs, result.data(), result.getLd(), memoryBytes);
+    return result;
+}
+
+// Times one Strassen level against the blocked GEMM at doubling sizes (up to maxSize) and sets the
+// crossover between the last size where GEMM won and the first where Strassen did. Returns it.
+template <class T>
+int tuneStrassenCrossover(int maxSize = 4096) {
+    using clock = chrono::steady_clock;
+    int crossover = maxSize;
+    for (int n = 256; n <= maxSize; n *= 2) {
+        BasicMatrix<T> A(n, n), B(n, n), C(n, n);
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) {
+                A(i, j) = T((i * 7 + j * 3) % 17) / 17;
+                B(i, j) = T((i * 5 + j * 11) % 13) / 13;
+            }
+        }
+        auto best = [&](auto&& run) {
+            double t = 1e300;
+            for (int rep = 0; rep < 3; rep++) {
+                const auto t0 = clock::now();
+                run();
+                t = min(t, chrono::duration<double>(clock::now() - t0).count());
+            }
+            return t;
+        };
+        const double classical = best([&] { gemm<T>(n, n, n, T(1), A.data(), n, 1, B.data(), n, 1, T(0), C.data(), n); });
+        const double oneLevel = best([&] { strassen<T>(n, n, n, A.data(), n, 1, B.data(), n, 1, C.data(), n, strassenBudget, n - 1); });
+        // A clear margin, so timing noise does not pull the crossover down
+        if (oneLevel < 0.95 * classical) {
+            crossover = n * 3 / 4;
+            break;
+        }
+    }
+    setStrassenCrossover(crossover);
+    return crossover;
+}
+
+#endif  // STRASSEN_H
@@ -7,7 +7,12 @@
 #include <algorithm>
 #include <type_traits>
 #include <cstddef>
+#include <utility>
 #include <ostream>
+#include <memory>
+#include <string>
+#include "SmallVector.h"
+#include "TensorOps.h"
 
 using namespace std; // 👈 your preference
 
@@ -21,19 +26,25 @@ struct Range {
     }
 };
 
+// N-dimensional array over reference-counted storage. Copies and the shape-only operations
+// (squeeze, unsqueeze, view, transpose, slice) are views: they share the element buffer, so writes
+// through one are seen by all, and the buffer lives as long as any of them. clone() makes an
+// independent copy. A view addresses its elements as offset + sum(index[d] * strides[d]); slices and
+// transposes are not contiguous, and contiguous() copies such a view into a fresh row-major buffer.
 template <class T>
 class Tensor {
 public:
     using value_type      = T;
     using size_type       = size_t;
-    using shape_type      = vector<size_type>;
-    using strides_type    = vector<size_type>;
+    using shape_type      = SmallVector<size_type, 8>;   // inline up to 8 dimensions
+    using strides_type    = SmallVector<size_type, 8>;
     using container_type  = vector<T>;
     using iterator        = typename container_type::iterator;
     using const_iterator  = typename container_type::const_iterator;
 
     // ───────────── constructors ─────────────
-    Tensor() = default;
+    // Empty tensor without storage
+    Tensor() noexcept = default;
 
     // Construct with shape and optional initial value
     explicit Tensor(shape_type shape, const T& init = T())
@@ -41,88 +52,193 @@ public:
     {
         validate_shape();
         compute_strides();
-        data_.assign(numel(), init);
+        storage_ = make_shared<container_type>(numel(), init);
     }
 
     // Construct from data (flattened) and shape
     Tensor(container_type data, shape_type shape)
-        : data_(move(data)), shape_(move(shape))
+        : storage_(make_shared<container_type>(move(data))), shape_(move(shape))
     {
         validate_shape();
         compute_strides();
-        if (data_.size() != numel())
+        if (storage_->size() != numel())
             throw invalid_argument("Data size does not match shape product.");
     }
 
     // Construct from initializer_list for 1D
     Tensor(initializer_list<T> list)
-        : data_(list), shape_{list.size()}
+        : storage_(make_shared<container_type>(list)), shape_{list.size()}
     {
         compute_strides();
     }
 
+    // Deep copy with its own contiguous buffer (copy construction and assignment share the buffer instead)
+    Tensor clone() const {
+        container_type out(numel());
+        copy_to(out.data());
+        return Tensor(move(out), shape_);
+    }
+
+    // This tensor when its elements are already contiguous in row-major order, a packed copy otherwise
+    Tensor contiguous() const {
+        return is_contiguous() ? *this : clone();
+    }
+
+    // True when both tensors are views of the same buffer
+    bool shares_storage(const Tensor& other) const noexcept { return storage_ && storage_ == other.storage_; }
+
     // ───────────── basic info ─────────────
     size_type ndim() const noexcept { return shape_.size(); }
     const shape_type& shape() const noexcept { return shape_; }
     const strides_type& strides() const noexcept { return strides_; }
-    size_type size() const noexcept { return data_.size(); }
+    size_type offset() const noexcept { return offset_; }
+    size_type size() const noexcept { return numel(); }
     size_type numel() const noexcept {
         return shape_.empty()
              ? 0
              : accumulate(shape_.begin(), shape_.end(), size_type{1}, multiplies<size_type>());
     }
 
+    // True when the elements occupy numel() consecutive slots in row-major order
+    bool is_contiguous() const noexcept {
+        size_type expected = 1;
+        for (size_type i = ndim(); i-- > 0;) {
+            if (shape_[i] != 1 && strides_[i] != expected) return false;
+            expected *= shape_[i];
+        }
+        return true;
+    }
+
     // ───────────── data access ─────────────
-    // Access with vector of indices
-    T& at(const shape_type& idx) { return data_.at(flat_index_checked(idx)); }
-    const T& at(const shape_type& idx) const { return data_.at(flat_index_checked(idx)); }
+    // Access with vector of indices. The checks run before storage_ is touched: a default-constructed
+    // tensor has none, and they are what reject indexing it.
+    T& at(const shape_type& idx) {
+        const size_type off = flat_index_checked(idx);
+        return storage_->data()[off];
+    }
+    const T& at(const shape_type& idx) const {
+        const size_type off = flat_index_checked(idx);
+        return storage_->data()[off];
+    }
 
-    // Variadic operator()
+    // Variadic operator(): rank and bounds checked, without building an index vector
     template <class... Indexes,
               class = enable_if_t<(conjunction_v<is_integral<Indexes>...>)>>
     T& operator()(Indexes... is) {
-        shape_type idx{ static_cast<size_type>(is)... };
-        return at(idx);
+        const size_type off = checked_offset(is...);
+        return storage_->data()[off];
     }
     template <class... Indexes,
               class = enable_if_t<(conjunction_v<is_integral<Indexes>...>)>>
     const T& operator()(Indexes... is) const {
-        shape_type idx{ static_cast<size_type>(is)... };
-        return at(idx);
+        const size_type off = checked_offset(is...);
+        return storage_->data()[off];
+    }
+
+    // Unchecked element access for inner loops: one multiply-add per index, no rank or bounds checks
+    template <class... Indexes,
+              class = enable_if_t<(conjunction_v<is_integral<Indexes>...>)>>
+    T& unchecked(Indexes... is) noexcept {
+        return storage_->data()[fold_offset(index_sequence_for<Indexes...>(), is...)];
+    }
+    template <class... Indexes,
+              class = enable_if_t<(conjunction_v<is_integral<Indexes>...>)>>
+    const T& unchecked(Indexes... is) const noexcept {
+        return storage_->data()[fold_offset(index_sequence_for<Indexes...>(), is...)];
     }
 
-    // Iteration
-    iterator begin() noexcept { return data_.begin(); }
-    iterator end() noexcept { return data_.end(); }
-    const_iterator begin() const noexcept { return data_.begin(); }
-    const_iterator end() const noexcept { return data_.end(); }
+    // First element; element (i, j, ...) is at data()[i * strides()[0] + j * strides()[1] + ...]
+    T* data() noexcept { return storage_ ? storage_->data() + offset_ : nullptr; }
+    const T* data() const noexcept { return storage_ ? storage_->data() + offset_ : nullptr; }
+
+    // Iteration in row-major order; needs a contiguous tensor (see contiguous())
+    iterator begin() { return storage_ ? storage_->begin() + contiguous_offset("begin") : iterator(); }
+    iterator end() { return storage_ ? begin() + numel() : iterator(); }
+    const_iterator begin() const { return storage_ ? storage_->cbegin() + contiguous_offset("begin") : const_iterator(); }
+    const_iterator end() const { return storage_ ? begin() + numel() : const_iterator(); }
 
     // Fill
-    void fill(const T& v) { std::fill(data_.begin(), data_.end(), v); }
+    void fill(const T& v) {
+        if (!storage_) return;
+        T* p = storage_->data();
+        for_each_offset([&](size_type off) { p[off] = v; });
+    }
 
-    // Reshape (keeps elements count the same)
+    // Reshape (keeps elements count the same); a non-contiguous tensor is packed into its own buffer first
     void reshape(shape_type new_shape) {
         if (product(new_shape) != numel())
             throw invalid_argument("reshape: total elements must remain constant.");
+        if (!is_contiguous()) *this = clone();
         shape_ = move(new_shape);
         compute_strides();
     }
 
+    // Reshaped view sharing this tensor's elements; needs a contiguous tensor
+    Tensor view(shape_type new_shape) const {
+        if (product(new_shape) != numel())
+            throw invalid_argument("view: total elements must remain constant.");
+        const size_type off = contiguous_offset("view");
+        Tensor result(storage_, move(new_shape), strides_type(), off);
+        result.compute_strides();
+        return result;
+    }
+
+    // View with dimensions dim0 and dim1 swapped
+    Tensor transpose(size_type dim0, size_type dim1) const {
+        if (dim0 >= ndim() || dim1 >= ndim()) {
+            throw out_of_range("Dimension index out of range for transpose.");
+        }
+        Tensor result(*this);
+        swap(result.shape_[dim0], result.shape_[dim1]);
+        swap(result.strides_[dim0], result.strides_[dim1]);
+        return result;
+    }
+
+    // View of the elements start, start + step, ... (before stop) along dim
+    Tensor slice(size_type dim, const Range& r) const {
+        if (dim >= ndim()) {
+            throw out_of_range("Dimension index out of range for slice.");
+        }
+        if (r.start >= r.stop || r.stop > shape_[dim]) {
+            throw out_of_range("Slice range out of bounds or empty.");
+        }
+        Tensor result(*this);
+        result.offset_ += r.start * strides_[dim];
+        result.shape_[dim] = (r.stop - r.start + r.step - 1) / r.step;
+        result.strides_[dim] *= r.step;
+        return result;
+    }
+
+    // Slices the leading dimensions, one Range per dimension: t[{Range(0, 2), Range(1, 4, 2)}]
+    Tensor operator[](const vector<Range>& ranges) const {
+        if (ranges.size() > ndim()) {
+            throw invalid_argument("More slice ranges than dimensions.");
+        }
+        Tensor result(*this);
+        for (size_type d = 0; d < ranges.size(); ++d) {
+            result = result.slice(d, ranges[d]);
+        }
+        return result;
+    }
+
     // Squeeze: remove dimensions of size 1
     Tensor squeeze() const {
+        if (ndim() == 0) return *this;
         shape_type new_shape;
-        for (size_type dim : shape_) {
-            if (dim != 1) {
-                new_shape.push_back(dim);
+        strides_type new_strides;
+        for (size_type i = 0; i < ndim(); ++i) {
+            if (shape_[i] != 1) {
+                new_shape.push_back(shape_[i]);
+                new_strides.push_back(strides_[i]);
             }
         }
         // If all dimensions were 1, keep at least one dimension
         if (new_shape.empty()) {
             new_shape.push_back(1);
+            new_strides.push_back(1);
         }
         
-        Tensor result(data_, new_shape);
-        return result;
+        return Tensor(storage_, move(new_shape), move(new_strides), offset_);
     }
 
     // Squeeze specific dimension (only if it has size 1)
@@ -135,35 +251,41 @@ public:
         }
         
         shape_type new_shape;
+        strides_type new_strides;
         for (size_type i = 0; i < ndim(); ++i) {
             if (i != dim) {
                 new_shape.push_back(shape_[i]);
+                new_strides.push_back(strides_[i]);
             }
         }
         // If we removed the last dimension, keep at least one dimension
         if (new_shape.empty()) {
             new_shape.push_back(1);
+            new_strides.push_back(1);
         }
         
-        Tensor result(data_, new_shape);
-        return result;
+        return Tensor(storage_, move(new_shape), move(new_strides), offset_);
     }
 
     // Squeeze in-place: remove dimensions of size 1
     void squeeze_() {
+        if (ndim() == 0) return;
         shape_type new_shape;
-        for (size_type dim : shape_) {
-            if (dim != 1) {
-                new_shape.push_back(dim);
+        strides_type new_strides;
+        for (size_type i = 0; i < ndim(); ++i) {
+            if (shape_[i] != 1) {
+                new_shape.push_back(shape_[i]);
+                new_strides.push_back(strides_[i]);
             }
         }
         // If all dimensions were 1, keep at least one dimension
         if (new_shape.empty()) {
             new_shape.push_back(1);
+            new_strides.push_back(1);
         }
         
         shape_ = move(new_shape);
-        compute_strides();
+        strides_ = move(new_strides);
     }
 
     // Squeeze specific dimension in-place (only if it has size 1)
@@ -176,18 +298,21 @@ public:
         }
         
         shape_type new_shape;
+        strides_type new_strides;
         for (size_type i = 0; i < ndim(); ++i) {
             if (i != dim) {
                 new_shape.push_back(shape_[i]);
+                new_strides.push_back(strides_[i]);
             }
         }
         // If we removed the last dimension, keep at least one dimension
         if (new_shape.empty()) {
             new_shape.push_back(1);
+            new_strides.push_back(1);
         }
         
         shape_ = move(new_shape);
-        compute_strides();
+        strides_ = move(new_strides);
     }
 
     // Unsqueeze: add a dimension of size 1 at specified position
@@ -195,21 +320,27 @@ public:
         if (dim > ndim()) {
             throw out_of_range("Dimension index out of range for unsqueeze.");
         }
+        if (ndim() == 0) {
+            throw invalid_argument("Cannot unsqueeze an empty tensor.");
+        }
         
         shape_type new_shape;
+        strides_type new_strides;
         for (size_type i = 0; i < ndim(); ++i) {
             if (i == dim) {
                 new_shape.push_back(1);  // Insert dimension of size 1
+                new_strides.push_back(strides_[i] * shape_[i]);
             }
             new_shape.push_back(shape_[i]);
+            new_strides.push_back(strides_[i]);
         }
         // If dim equals ndim(), add the dimension at the end
         if (dim == ndim()) {
             new_shape.push_back(1);
+            new_strides.push_back(1);
         }
         
-        Tensor result(data_, new_shape);
-        return result;
+        return Tensor(storage_, move(new_shape), move(new_strides), offset_);
     }
 
     // Unsqueeze in-place: add a dimension of size 1 at specified position
@@ -217,41 +348,269 @@ public:
         if (dim > ndim()) {
             throw out_of_range("Dimension index out of range for unsqueeze.");
         }
+        if (ndim() == 0) {
+            throw invalid_argument("Cannot unsqueeze an empty tensor.");
+        }
         
         shape_type new_shape;
+        strides_type new_strides;
         for (size_type i = 0; i < ndim(); ++i) {
             if (i == dim) {
                 new_shape.push_back(1);  // Insert dimension of size 1
+                new_strides.push_back(strides_[i] * shape_[i]);
             }
             new_shape.push_back(shape_[i]);
+            new_strides.push_back(strides_[i]);
         }
         // If dim equals ndim(), add the dimension at the end
         if (dim == ndim()) {
             new_shape.push_back(1);
+            new_strides.push_back(1);
         }
         
         shape_ = move(new_shape);
-        compute_strides();
+        strides_ = move(new_strides);
+    }
+
+    // ───────────── element-wise arithmetic ─────────────
+    // Operands broadcast against each other by the NumPy rules (TensorOps.h) and results are new
+    // contiguous tensors; comparisons give masks of T(1) and T(0). The compound assignments write into
+    // this tensor, through a view too, and need the other operand to broadcast to its shape; an operand
+    // that views this tensor's storage with another layout (t += t.transpose(0, 1)) is copied first.
+    friend Tensor operator+(const Tensor& a, const Tensor& b) { return binary<BinaryOp::add>(a.arg(), b.arg()); }
+    friend Tensor operator-(const Tensor& a, const Tensor& b) { return binary<BinaryOp::sub>(a.arg(), b.arg()); }
+    friend Tensor operator*(const Tensor& a, const Tensor& b) { return binary<BinaryOp::mul>(a.arg(), b.arg()); }
+    friend Tensor operator/(const Tensor& a, const Tensor& b) { return binary<BinaryOp::div>(a.arg(), b.arg()); }
+    friend Tensor operator==(const Tensor& a, const Tensor& b) { return binary<BinaryOp::eq>(a.arg(), b.arg()); }
+    friend Tensor operator!=(const Tensor& a, const Tensor& b) { return binary<BinaryOp::ne>(a.arg(), b.arg()); }
+    friend Tensor operator<(const Tensor& a, const Tensor& b) { return binary<BinaryOp::lt>(a.arg(), b.arg()); }
+    friend Tensor operator<=(const Tensor& a, const Tensor& b) { return binary<BinaryOp::le>(a.arg(), b.arg()); }
+    friend Tensor operator>(const Tensor& a, const Tensor& b) { return binary<BinaryOp::gt>(a.arg(), b.arg()); }
+    friend Tensor operator>=(const Tensor& a, const Tensor& b) { return binary<BinaryOp::ge>(a.arg(), b.arg()); }
+
+    friend Tensor operator+(const Tensor& a, const T& s) { return binary<BinaryOp::add>(a.arg(), arg(s)); }
+    friend Tensor operator-(const Tensor& a, const T& s) { return binary<BinaryOp::sub>(a.arg(), arg(s)); }
+    friend Tensor operator*(const Tensor& a, const T& s) { return binary<BinaryOp::mul>(a.arg(), arg(s)); }
+    friend Tensor operator/(const Tensor& a, const T& s) { return binary<BinaryOp::div>(a.arg(), arg(s)); }
+    friend Tensor operator==(const Tensor& a, const T& s) { return binary<BinaryOp::eq>(a.arg(), arg(s)); }
+    friend Tensor operator!=(const Tensor& a, const T& s) { return binary<BinaryOp::ne>(a.arg(), arg(s)); }
+    friend Tensor operator<(const Tensor& a, const T& s) { return binary<BinaryOp::lt>(a.arg(), arg(s)); }
+    friend Tensor operator<=(const Tensor& a, const T& s) { return binary<BinaryOp::le>(a.arg(), arg(s)); }
+    friend Tensor operator>(const Tensor& a, const T& s) { return binary<BinaryOp::gt>(a.arg(), arg(s)); }
+    friend Tensor operator>=(const Tensor& a, const T& s) { return binary<BinaryOp::ge>(a.arg(), arg(s)); }
+
+    friend Tensor operator+(const T& s, const Tensor& b) { return binary<BinaryOp::add>(arg(s), b.arg()); }
+    friend Tensor operator-(const T& s, const Tensor& b) { return binary<BinaryOp::sub>(arg(s), b.arg()); }
+    friend Tensor operator*(const T& s, const Tensor& b) { return binary<BinaryOp::mul>(arg(s), b.arg()); }
+    friend Tensor operator/(const T& s, const Tensor& b) { return binary<BinaryOp::div>(arg(s), b.arg()); }
+
+    Tensor& operator+=(const Tensor& b) { return assign<BinaryOp::add>(b); }
+    Tensor& operator-=(const Tensor& b) { return assign<BinaryOp::sub>(b); }
+    Tensor& operator*=(const Tensor& b) { return assign<BinaryOp::mul>(b); }
+    Tensor& operator/=(const Tensor& b) { return assign<BinaryOp::div>(b); }
+    Tensor& operator+=(const T& s) { return assign<BinaryOp::add>(arg(s)); }
+    Tensor& operator-=(const T& s) { return assign<BinaryOp::sub>(arg(s)); }
+    Tensor& operator*=(const T& s) { return assign<BinaryOp::mul>(arg(s)); }
+    Tensor& operator/=(const T& s) { return assign<BinaryOp::div>(arg(s)); }
+
+    // a * b + c rounded once
+    friend Tensor fma(const Tensor& a, const Tensor& b, const Tensor& c) {
+        const Arg x = a.arg(), y = b.arg(), z = c.arg();
+        Tensor out = result_for({x.dims, y.dims, z.dims});
+        const auto loop = tensor_detail::makeLoop<4>({out.arg().dims, x.dims, y.dims, z.dims});
+        const auto& in = loop.strides.back();
+        const auto kernel = tensor_detail::fmaKernel<T>();
+        T* o = out.storage_->data();
+        tensor_detail::forEachRow(loop, [&](size_t n, const array<size_t, 4>& off) {
+            kernel(n, o + off[0], in[0], x.p + off[1], in[1], y.p + off[2], in[2], z.p + off[3], in[3]);
+        });
+        return out;
     }
 
+    friend Tensor operator-(const Tensor& a) { return unary<UnaryOp::neg>(a); }
+    friend Tensor abs(const Tensor& a) { return unary<UnaryOp::abs>(a); }
+    friend Tensor sqrt(const Tensor& a) { return unary<UnaryOp::sqrt>(a); }
+    friend Tensor exp(const Tensor& a) { return unary<UnaryOp::exp>(a); }
+    friend Tensor log(const Tensor& a) { return unary<UnaryOp::log>(a); }
+    friend Tensor tanh(const Tensor& a) { return unary<UnaryOp::tanh>(a); }
+
     // Pretty-print
     friend ostream& operator<<(ostream& os, const Tensor& t) {
         os << "Tensor<>, shape=[";
         for (size_type i = 0; i < t.ndim(); ++i)
             os << t.shape_[i] << (i+1==t.ndim()?"] ":"x ");
         os << "size=" << t.size() << " data=[";
-        for (size_type i = 0; i < t.size(); ++i) {
-            os << t.data_[i];
-            if (i+1 != t.size()) os << ", ";
-        }
+        size_type i = 0;
+        t.for_each_offset([&](size_type off) {
+            os << (*t.storage_)[off];
+            if (++i != t.size()) os << ", ";
+        });
         os << "]]";
         return os;
     }
 
 private:
-    container_type data_;
+    shared_ptr<container_type> storage_;
     shape_type     shape_;
     strides_type   strides_;
+    size_type      offset_ = 0;
+
+    // Side of the square tiles contiguous() copies a view through, so that both the reads and the
+    // writes of a transposed layout stay within a few cache lines
+    static constexpr size_type copy_tile = 32;
+
+    using BinaryOp = tensor_detail::BinaryOp;
+    using UnaryOp = tensor_detail::UnaryOp;
+
+    // Element-wise operand: first element and layout, or a scalar
+    struct Arg {
+        const T* p;
+        tensor_detail::Dims dims;
+    };
+
+    Arg arg() const {
+        if (numel() == 0) throw invalid_argument("Element-wise operation on an empty tensor.");
+        return {data(), {shape_.data(), strides_.data(), ndim()}};
+    }
+
+    static Arg arg(const T& s) { return {&s, {nullptr, nullptr, 0}}; }
+
+    // New tensor of the shape the operands broadcast to
+    static Tensor result_for(initializer_list<tensor_detail::Dims> operands) {
+        shape_type shape;
+        for (const auto& d : operands) tensor_detail::broadcastInto(shape, d);
+        return Tensor(move(shape));
+    }
+
+    template <BinaryOp op>
+    static Tensor binary(const Arg& a, const Arg& b) {
+        Tensor out = result_for({a.dims, b.dims});
+        const auto loop = tensor_detail::makeLoop<3>({out.arg().dims, a.dims, b.dims});
+        const auto& in = loop.strides.back();
+        const auto kernel = tensor_detail::binaryKernel<T, op>();
+        T* o = out.storage_->data();
+        tensor_detail::forEachRow(loop, [&](size_t n, const array<size_t, 3>& off) {
+            kernel(n, o + off[0], in[0], a.p + off[1], in[1], b.p + off[2], in[2]);
+        });
+        return out;
+    }
+
+    template <BinaryOp op>
+    Tensor& assign(const Arg& b) {
+        const Arg a = arg();
+        shape_type shape = shape_;
+        tensor_detail::broadcastInto(shape, b.dims);
+        if (shape != shape_)
+            throw invalid_argument("Compound assignment cannot change the tensor's shape.");
+        const auto loop = tensor_detail::makeLoop<3>({a.dims, a.dims, b.dims});
+        const auto& in = loop.strides.back();
+        const auto kernel = tensor_detail::binaryKernel<T, op>();
+        T* o = data();
+        tensor_detail::forEachRow(loop, [&](size_t n, const array<size_t, 3>& off) {
+            kernel(n, o + off[0], in[0], a.p + off[1], in[1], b.p + off[2], in[2]);
+        });
+        return *this;
+    }
+
+    // Elements of b are read while this tensor is written, row by row and across threads. Reading the
+    // element being written is fine (t += t); any other element of the same storage may already be done.
+    template <BinaryOp op>
+    Tensor& assign(const Tensor& b) {
+        if (b.shares_storage(*this) && (b.offset_ != offset_ || b.shape_ != shape_ || b.strides_ != strides_))
+            return assign<op>(b.clone().arg());
+        return assign<op>(b.arg());
+    }
+
+    template <UnaryOp op>
+    static Tensor unary(const Tensor& t) {
+        const Arg a = t.arg();
+        Tensor out(t.shape_);
+        const auto loop = tensor_detail::makeLoop<2>({out.arg().dims, a.dims});
+        const auto& in = loop.strides.back();
+        T* o = out.storage_->data();
+        tensor_detail::forEachRow(loop, [&](size_t n, const array<size_t, 2>& off) {
+            tensor_detail::unaryRow<T, op>(n, o + off[0], in[0], a.p + off[1], in[1]);
+        });
+        return out;
+    }
+
+    // View over existing storage
+    Tensor(shared_ptr<container_type> storage, shape_type shape, strides_type strides, size_type offset)
+        : storage_(move(storage)), shape_(move(shape)), strides_(move(strides)), offset_(offset) {}
+
+    size_type contiguous_offset(const char* what) const {
+        if (!is_contiguous())
+            throw logic_error(string(what) + ": tensor is not contiguous; call contiguous() first.");
+        return offset_;
+    }
+
+    // Calls f(offset) with the storage offset of the first element of each block spanned by the last
+    // `inner` dimensions, blocks in row-major order
+    template <class F>
+    void for_each_block(size_type inner, F&& f) const {
+        const size_type outer = ndim() - inner;
+        shape_type idx(outer, 0);
+        size_type off = offset_;
+        for (;;) {
+            f(off);
+            size_type k = outer;
+            for (; k > 0; --k) {
+                off += strides_[k-1];
+                if (++idx[k-1] < shape_[k-1]) break;
+                off -= idx[k-1] * strides_[k-1];
+                idx[k-1] = 0;
+            }
+            if (k == 0) return;
+        }
+    }
+
+    // Calls f(offset) for every element in row-major order
+    template <class F>
+    void for_each_offset(F&& f) const {
+        if (numel() == 0) return;
+        if (is_contiguous()) {
+            for (size_type i = 0, n = numel(); i < n; ++i) f(offset_ + i);
+            return;
+        }
+        const size_type n = shape_.back(), s = strides_.back();
+        for_each_block(1, [&](size_type off) {
+            for (size_type j = 0; j < n; ++j) f(off + j * s);
+        });
+    }
+
+    // Writes the elements to dst in row-major order; the last two dimensions are copied in tiles
+    void copy_to(T* dst) const {
+        if (numel() == 0) return;
+        const T* src = storage_->data();
+        if (is_contiguous()) {
+            copy(src + offset_, src + offset_ + numel(), dst);
+            return;
+        }
+        if (ndim() == 1) {
+            for_each_offset([&](size_type off) { *dst++ = src[off]; });
+            return;
+        }
+        const size_type rows = shape_[ndim()-2], cols = shape_[ndim()-1];
+        const size_type rs = strides_[ndim()-2], cs = strides_[ndim()-1];
+        for_each_block(2, [&](size_type off) {
+            const T* s = src + off;
+            if (cs == 1) {
+                for (size_type i = 0; i < rows; ++i)
+                    copy(s + i * rs, s + i * rs + cols, dst + i * cols);
+            } else {
+                for (size_type i0 = 0; i0 < rows; i0 += copy_tile) {
+                    const size_type i1 = min(rows, i0 + copy_tile);
+                    for (size_type j0 = 0; j0 < cols; j0 += copy_tile) {
+                        const size_type j1 = min(cols, j0 + copy_tile);
+                        for (size_type i = i0; i < i1; ++i)
+                            for (size_type j = j0; j < j1; ++j)
+                                dst[i * cols + j] = s[i * rs + j * cs];
+                    }
+                }
+            }
+            dst += rows * cols;
+        });
+    }
 
     void validate_shape() const {
         for (auto s : shape_)
@@ -269,14 +628,31 @@ private:
         return s.empty() ? 0 : accumulate(s.begin(), s.end(), size_type{1}, multiplies<size_type>());
     }
 
+    // offset_ + sum of is[d] * strides_[d], expanded at compile time
+    template <size_t... D, class... Indexes>
+    size_type fold_offset(index_sequence<D...>, Indexes... is) const noexcept {
+        return (offset_ + ... + (static_cast<size_type>(is) * strides_[D]));
+    }
+
+    template <class... Indexes>
+    size_type checked_offset(Indexes... is) const {
+        if (sizeof...(Indexes) != ndim()) throw invalid_argument("Index rank mismatch.");
+        if (sizeof...(Indexes) == 0) throw out_of_range("Index out of bounds.");  // an empty tensor
+        const array<size_type, sizeof...(Indexes)> idx{static_cast<size_type>(is)...};
+        for (size_type i = 0; i < sizeof...(Indexes); ++i)
+            if (idx[i] >= shape_[i]) throw out_of_range("Index out of bounds.");
+        return fold_offset(index_sequence_for<Indexes...>(), is...);
+    }
+
     size_type flat_index_checked(const shape_type& idx) const {
         if (idx.size() != ndim()) throw invalid_argument("Index rank mismatch.");
+        if (idx.empty()) throw out_of_range("Index out of bounds.");  // an empty tensor
         size_type off = 0;
         for (size_type i = 0; i < idx.size(); ++i) {
             if (idx[i] >= shape_[i]) throw out_of_range("Index out of bounds.");
             off += idx[i] * strides_[i];
         }
-        return off;
+        return offset_ + off;
     }
 };
 
@@ -0,0 +1,336 @@
+#ifndef TENSOROPS_H
+#define TENSOROPS_H
+
+#include <vector>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include "SmallVector.h"
+#include "ThreadPool.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TENSOR_VECTOR_EXTENSIONS 1
+#define TENSOR_ALWAYS_INLINE __attribute__((always_inline)) inline
+#else
+#define TENSOR_ALWAYS_INLINE inline
+#endif
+
+#if defined(TENSOR_VECTOR_EXTENSIONS) && (defined(__x86_64__) || defined(__i386__))
+#define TENSOR_X86_DISPATCH 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// Element-wise kernels and the broadcast loop behind Tensor arithmetic.
+// Operand shapes broadcast by the NumPy rules: they are aligned at the last dimension, and in each
+// dimension the sizes must agree except that a size of 1 (or a missing leading dimension) stretches
+// to the others by reading with stride 0. The loop drops size-1 dimensions and merges neighbours that
+// every operand walks as one run, so a contiguous operation becomes a single row. Rows go to a row
+// kernel: for float and double, an AVX-512, AVX2 or baseline SIMD kernel picked once at run time
+// handles rows where every operand has stride 1 or 0 (a broadcast value); other rows run scalar, as
+// does everything on compilers without GCC/Clang vector extensions.
+// Large loops are split across the thread pool by rows, or a single long row by ranges.
+
+namespace tensor_detail {
+
+// Shape and strides of one operand, in elements; ndim 0 is a scalar
+struct Dims {
+    const size_t* shape;
+    const size_t* strides;
+    size_t ndim;
+};
+
+// Shapes and index counters of up to 8 dimensions without allocating
+using Extents = SmallVector<size_t, 8>;
+
+// Broadcasts `out` (the shape so far) against d, in place
+inline void broadcastInto(Extents& out, const Dims& d) {
+    if (d.ndim > out.size()) out.insert(out.begin(), d.ndim - out.size(), 1);
+    const size_t lead = out.size() - d.ndim;
+    for (size_t i = 0; i < d.ndim; ++i) {
+        size_t& o = out[lead + i];
+        if (o == 1) {
+            o = d.shape[i];
+        } else if (d.shape[i] != 1 && d.shape[i] != o) {
+            throw invalid_argument("Tensor shapes cannot be broadcast together.");
+        }
+    }
+}
+
+// Loop over the broadcast shape: dims after dropping size-1 ones and merging, innermost last,
+// and strides[d][k] of operand k in each (0 where it is broadcast)
+template <size_t N>
+struct BroadcastLoop {
+    Extents shape;
+    SmallVector<array<size_t, N>, 8> strides;
+};
+
+// ops[0] is the output, whose shape is the full broadcast shape
+template <size_t N>
+BroadcastLoop<N> makeLoop(const array<Dims, N>& ops) {
+    BroadcastLoop<N> loop;
+    const size_t rank = ops[0].ndim;
+    for (size_t d = 0; d < rank; ++d) {
+        const size_t n = ops[0].shape[d];
+        if (n == 1) continue;
+        array<size_t, N> s;
+        for (size_t k = 0; k < N; ++k) {
+            const size_t lead = rank - ops[k].ndim;
+            s[k] = (d < lead || ops[k].shape[d - lead] == 1) ? 0 : ops[k].strides[d - lead];
+        }
+        if (!loop.shape.empty()) {
+            bool merge = true;
+            for (size_t k = 0; k < N; ++k) merge = merge && loop.strides.back()[k] == s[k] * n;
+            if (merge) {
+                loop.shape.back() *= n;
+                loop.strides.back() = s;
+                continue;
+            }
+        }
+        loop.shape.push_back(n);
+        loop.strides.push_back(s);
+    }
+    if (loop.shape.empty()) {
+        loop.shape.push_back(1);
+        loop.strides.push_back(array<size_t, N>{});
+    }
+    return loop;
+}
+
+// Calls row(n, off) for every innermost row, off[k] being operand k's offset of the row's first
+// element. Rows are spread over the thread pool; a loop that is a single row is split into ranges.
+template <size_t N, class F>
+void forEachRow(const BroadcastLoop<N>& loop, F&& row) {
+    const size_t d = loop.shape.size();
+    const size_t inner = loop.shape[d - 1];
+    const array<size_t, N>& step = loop.strides[d - 1];
+    size_t rows = 1;
+    for (size_t i = 0; i + 1 < d; ++i) rows *= loop.shape[i];
+    if (rows == 1) {
+        parallelFor(0, inner, 1, [&](size_t lo, size_t hi) {
+            array<size_t, N> off;
+            for (size_t k = 0; k < N; ++k) off[k] = lo * step[k];
+            row(hi - lo, off);
+        });
+        return;
+    }
+    parallelFor(0, rows, inner, [&](size_t lo, size_t hi) {
+        // Offsets of row lo, then advanced like an odometer
+        Extents idx(d - 1, 0);
+        array<size_t, N> off{};
+        for (size_t i = d - 1, r = lo; i-- > 0; r /= loop.shape[i]) {
+            idx[i] = r % loop.shape[i];
+            for (size_t k = 0; k < N; ++k) off[k] += idx[i] * loop.strides[i][k];
+        }
+        for (size_t q = lo; q < hi; ++q) {
+            row(inner, off);
+            for (size_t i = d - 1; i-- > 0;) {
+                for (size_t k = 0; k < N; ++k) off[k] += loop.strides[i][k];
+                if (++idx[i] < loop.shape[i]) break;
+                for (size_t k = 0; k < N; ++k) off[k] -= idx[i] * loop.strides[i][k];
+                idx[i] = 0;
+            }
+        }
+    });
+}
+
+// ───────────── operations ─────────────
+
+enum class BinaryOp { add, sub, mul, div, eq, ne, lt, le, gt, ge };
+enum class UnaryOp { neg, abs, sqrt, exp, log, tanh };
+
+// r = a op b for scalars and for GCC vector types alike; comparisons give one or zero
+template <BinaryOp op, class V>
+TENSOR_ALWAYS_INLINE void apply(V& r, const V& a, const V& b, const V& one) {
+    if constexpr (op == BinaryOp::add) r = a + b;
+    else if constexpr (op == BinaryOp::sub) r = a - b;
+    else if constexpr (op == BinaryOp::mul) r = a * b;
+    else if constexpr (op == BinaryOp::div) r = a / b;
+    else if constexpr (op == BinaryOp::eq) r = a == b ? one : V{};
+    else if constexpr (op == BinaryOp::ne) r = a != b ? one : V{};
+    else if constexpr (op == BinaryOp::lt) r = a < b ? one : V{};
+    else if constexpr (op == BinaryOp::le) r = a <= b ? one : V{};
+    else if constexpr (op == BinaryOp::gt) r = a > b ? one : V{};
+    else r = a >= b ? one : V{};
+}
+
+template <UnaryOp op, class T>
+T apply(const T& a) {
+    if constexpr (op == UnaryOp::neg) return -a;
+    else if constexpr (op == UnaryOp::abs) return std::abs(a);
+    else if constexpr (op == UnaryOp::sqrt) return std::sqrt(a);
+    else if constexpr (op == UnaryOp::exp) return std::exp(a);
+    else if constexpr (op == UnaryOp::log) return std::log(a);
+    else return std::tanh(a);
+}
+
+// Row kernels: n elements, each operand as (pointer, stride); out may alias an input element for element
+template <class T>
+using BinaryRow = void (*)(size_t n, T* out, size_t so, const T* a, size_t sa, const T* b, size_t sb);
+
+template <class T>
+using FmaRow = void (*)(size_t n, T* out, size_t so, const T* a, size_t sa, const T* b, size_t sb,
+                        const T* c, size_t sc);
+
+template <class T, BinaryOp op>
+void binaryScalar(size_t n, T* out, size_t so, const T* a, size_t sa, const T* b, size_t sb) {
+    for (size_t i = 0; i < n; ++i) apply<op>(out[i * so], a[i * sa], b[i * sb], T(1));
+}
+
+template <class T>
+void fmaScalar(size_t n, T* out, size_t so, const T* a, size_t sa, const T* b, size_t sb, const T* c, size_t sc) {
+    for (size_t i = 0; i < n; ++i) out[i * so] = std::fma(a[i * sa], b[i * sb], c[i * sc]);
+}
+
+template <class T, UnaryOp op>
+void unaryRow(size_t n, T* out, size_t so, const T* a, size_t sa) {
+    for (size_t i = 0; i < n; ++i) out[i * so] = apply<op>(a[i * sa]);
+}
+
+// GCC vector extensions exist for float and double only
+template <class T>
+constexpr bool hasLanes = is_same<T, float>::value || is_same<T, double>::value;
+
+#ifdef TENSOR_VECTOR_EXTENSIONS
+
+// Whole SIMD registers of Bytes each where the output has stride 1 and the inputs 1 or 0, the rest scalar.
+// Always inlined, so it is compiled for the instruction set of the kernel it is expanded into.
+template <class T, size_t Bytes, BinaryOp op>
+TENSOR_ALWAYS_INLINE void binaryLanes(size_t n, T* out, size_t so, const T* a, size_t sa, const T* b, size_t sb) {
+    typedef T V __attribute__((vector_size(Bytes)));
+    constexpr size_t w = Bytes / sizeof(T);
+    size_t i = 0;
+    if (so == 1 && sa <= 1 && sb <= 1) {
+        const V one = V{} + T(1), va = V{} + a[0], vb = V{} + b[0];
+        for (; i + w <= n; i += w) {
+            V x = va, y = vb, r;
+            if (sa) memcpy(&x, a + i, Bytes);
+            if (sb) memcpy(&y, b + i, Bytes);
+            apply<op>(r, x, y, one);
+            memcpy(out + i, &r, Bytes);
+        }
+    }
+    for (; i < n; ++i) apply<op>(out[i * so], a[i * sa], b[i * sb], T(1));
+}
+
+template <class T, BinaryOp op>
+void binaryBaseline(size_t n, T* out, size_t so, const T* a, size_t sa, const T* b, size_t sb) {
+    binaryLanes<T, 16, op>(n, out, so, a, sa, b, sb);
+}
+
+#endif  // TENSOR_VECTOR_EXTENSIONS
+
+#ifdef TENSOR_X86_DISPATCH
+
+template <class T, BinaryOp op>
+__attribute__((target("avx2,fma")))
+void binaryAvx2(size_t n, T* out, size_t so, const T* a, size_t sa, const T* b, size_t sb) {
+    binaryLanes<T, 32, op>(n, out, so, a, sa, b, sb);
+}
+
+template <class T, BinaryOp op>
+__attribute__((target("avx512f")))
+void binaryAvx512(size_t n, T* out, size_t so, const T* a, size_t sa, const T* b, size_t sb) {
+    binaryLanes<T, 64, op>(n, out, so, a, sa, b, sb);
+}
+
+// Fused multiply-add needs the intrinsics: a * b + c on vector types would round twice
+template <class T>
+__attribute__((target("avx2,fma")))
+void fmaAvx2(size_t n, T* out, size_t so, const T* a, size_t sa, const T* b, size_t sb, const T* c, size_t sc) {
+    typedef T V __attribute__((vector_size(32)));
+    constexpr size_t w = 32 / sizeof(T);
+    size_t i = 0;
+    if (so == 1 && sa <= 1 && sb <= 1 && sc <= 1) {
+        const V va = V{} + a[0], vb = V{} + b[0], vc = V{} + c[0];
+        for (; i + w <= n; i += w) {
+            V x = va, y = vb, z = vc, r;
+            if (sa) memcpy(&x, a + i, 32);
+            if (sb) memcpy(&y, b + i, 32);
+            if (sc) memcpy(&z, c + i, 32);
+            if constexpr (is_same<T, double>::value) r = _mm256_fmadd_pd(x, y, z);
+            else r = _mm256_fmadd_ps(x, y, z);
+            memcpy(out + i, &r, 32);
+        }
+    }
+    for (; i < n; ++i) out[i * so] = std::fma(a[i * sa], b[i * sb], c[i * sc]);
+}
+
+template <class T>
+__attribute__((target("avx512f")))
+void fmaAvx512(size_t n, T* out, size_t so, const T* a, size_t sa, const T* b, size_t sb, const T* c, size_t sc) {
+    typedef T V __attribute__((vector_size(64)));
+    constexpr size_t w = 64 / sizeof(T);
+    size_t i = 0;
+    if (so == 1 && sa <= 1 && sb <= 1 && sc <= 1) {
+        const V va = V{} + a[0], vb = V{} + b[0], vc = V{} + c[0];
+        for (; i + w <= n; i += w) {
+            V x = va, y = vb, z = vc, r;
+            if (sa) memcpy(&x, a + i, 64);
+            if (sb) memcpy(&y, b + i, 64);
+            if (sc) memcpy(&z, c + i, 64);
+            if constexpr (is_same<T, double>::value) r = _mm512_fmadd_pd(x, y, z);
+            else r = _mm512_fmadd_ps(x, y, z);
+            memcpy(out + i, &r, 64);
+        }
+    }
+    for (; i < n; ++i) out[i * so] = std::fma(a[i * sa], b[i * sb], c[i * sc]);
+}
+
+inline bool cpuHasAvx2() {
+    static const bool has = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return has;
+}
+
+inline bool cpuHasAvx512() {
+    static const bool has = __builtin_cpu_supports("avx512f");
+    return has;
+}
+
+#endif  // TENSOR_X86_DISPATCH
+
+// Kernel selection happens once per element type and operation, on first use
+template <class T, BinaryOp op>
+BinaryRow<T> selectBinary() {
+    if constexpr (hasLanes<T>) {
+#ifdef TENSOR_X86_DISPATCH
+        if (cpuHasAvx512()) return &binaryAvx512<T, op>;
+        if (cpuHasAvx2()) return &binaryAvx2<T, op>;
+#endif
+#ifdef TENSOR_VECTOR_EXTENSIONS
+        return &binaryBaseline<T, op>;
+#endif
+    }
+    return &binaryScalar<T, op>;
+}
+
+template <class T, BinaryOp op>
+BinaryRow<T> binaryKernel() {
+    static const BinaryRow<T> k = selectBinary<T, op>();
+    return k;
+}
+
+template <class T>
+FmaRow<T> selectFma() {
+#ifdef TENSOR_X86_DISPATCH
+    if constexpr (hasLanes<T>) {
+        if (cpuHasAvx512()) return &fmaAvx512<T>;
+        if (cpuHasAvx2()) return &fmaAvx2<T>;
+    }
+#endif
+    return &fmaScalar<T>;
+}
+
+template <class T>
+FmaRow<T> fmaKernel() {
+    static const FmaRow<T> k = selectFma<T>();
+    return k;
+}
+
+}  // namespace tensor_detail
+
+#endif  // TENSOROPS_H
@@ -0,0 +1,214 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <exception>
+#include <algorithm>
+#include <cstddef>
+
+using namespace std;
+
+// Work-stealing thread pool. Every worker owns a deque: it pops its own tasks from the back
+// and, when empty, steals from the front of the others. The thread that calls parallelFor()
+// helps run tasks until its loop is finished, so nested parallel loops cannot deadlock.
+class ThreadPool {
+public:
+    // threads counts the calling thread, so ThreadPool(1) starts no workers and runs everything inline
+    explicit ThreadPool(int threads) : queues(max(threads, 1) - 1), queued(0), stop(false) {
+        for (auto& q : queues) q = make_unique<Queue>();
+        for (size_t i = 0; i < queues.size(); i++) {
+            workers.emplace_back([this, i] { workerLoop(static_cast<int>(i)); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            lock_guard<mutex> lk(sleepMutex);
+            stop = true;
+        }
+        wake.notify_all();
+        for (auto& w : workers) w.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return static_cast<int>(workers.size()) + 1; }
+
+    // Run body(lo, hi) over [begin, end) in chunks of at most `chunk` items and wait for all of them.
+    // The first exception thrown by any chunk is rethrown here once every chunk has finished.
+    template <class F>
+    void parallelFor(size_t begin, size_t end, size_t chunk, F&& body) {
+        if (begin >= end) return;
+        chunk = max<size_t>(chunk, 1);
+        const size_t tasks = (end - begin + chunk - 1) / chunk;
+        if (workers.empty() || tasks == 1) {
+            body(begin, end);
+            return;
+        }
+
+        using Body = typename remove_reference<F>::type;
+        Job job;
+        job.ctx = const_cast<void*>(static_cast<const void*>(&body));
+        job.run = [](void* ctx, size_t lo, size_t hi) { (*static_cast<Body*>(ctx))(lo, hi); };
+        job.remaining = tasks;
+
+        // A worker keeps its own tasks local (the others steal them); an outside caller deals them round-robin
+        const int self = currentWorker();
+        {
+            lock_guard<mutex> lk(sleepMutex);
+            queued += tasks;
+        }
+        size_t lo = begin;
+        for (size_t t = 0; t < tasks; t++, lo += chunk) {
+            Queue& q = *queues[self >= 0 ? self : t % queues.size()];
+            lock_guard<mutex> lk(q.m);
+            q.tasks.push_back(Task{&job, lo, min(lo + chunk, end)});
+        }
+        wake.notify_all();
+
+        while (job.remaining.load(memory_order_acquire) != 0) {
+            if (!runOne(self)) this_thread::yield();
+        }
+        if (job.error) rethrow_exception(job.error);
+    }
+
+private:
+    struct Job {
+        void (*run)(void*, size_t, size_t);
+        void* ctx;
+        atomic<size_t> remaining;
+        mutex errorMutex;
+        exception_ptr error;
+    };
+
+    struct Task {
+        Job* job;
+        size_t lo, hi;
+    };
+
+    struct Queue {
+        mutex m;
+        deque<Task> tasks;
+    };
+
+    vector<unique_ptr<Queue>> queues;
+    vector<thread> workers;
+    mutex sleepMutex;
+    condition_variable wake;
+    atomic<size_t> queued;
+    bool stop;
+
+    // Pool and queue index of the calling thread when it is a worker
+    static int& workerSlot() {
+        thread_local int slot = -1;
+        return slot;
+    }
+    static const ThreadPool*& workerPool() {
+        thread_local const ThreadPool* pool = nullptr;
+        return pool;
+    }
+    // Queue index of the calling thread if it is one of this pool's workers, -1 otherwise
+    int currentWorker() const { return workerPool() == this ? workerSlot() : -1; }
+
+    bool popOwn(int self, Task& out) {
+        Queue& q = *queues[self];
+        lock_guard<mutex> lk(q.m);
+        if (q.tasks.empty()) return false;
+        out = q.tasks.back();
+        q.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(int self, Task& out) {
+        const size_t n = queues.size();
+        const size_t start = self >= 0 ? self + 1 : 0;
+        for (size_t k = 0; k < n; k++) {
+            Queue& q = *queues[(start + k) % n];
+            lock_guard<mutex> lk(q.m);
+            if (q.tasks.empty()) continue;
+            out = q.tasks.front();
+            q.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    bool runOne(int self) {
+        Task t;
+        if (!(self >= 0 && popOwn(self, t)) && !steal(self, t)) return false;
+        queued.fetch_sub(1, memory_order_relaxed);
+        try {
+            t.job->run(t.job->ctx, t.lo, t.hi);
+        } catch (...) {
+            lock_guard<mutex> lk(t.job->errorMutex);
+            if (!t.job->error) t.job->error = current_exception();
+        }
+        t.job->remaining.fetch_sub(1, memory_order_release);
+        return true;
+    }
+
+    void workerLoop(int id) {
+        workerPool() = this;
+        workerSlot() = id;
+        for (;;) {
+            if (runOne(id)) continue;
+            unique_lock<mutex> lk(sleepMutex);
+            wake.wait(lk, [this] { return stop || queued.load() > 0; });
+            if (stop) return;
+        }
+    }
+};
+
+// Process-wide pool and settings shared by the Matrix kernels.
+// setNumThreads() rebuilds the pool, so call it between operations, not during one.
+inline unique_ptr<ThreadPool>& threadPoolSlot() {
+    static unique_ptr<ThreadPool> pool(new ThreadPool(max(1u, thread::hardware_concurrency())));
+    return pool;
+}
+
+inline ThreadPool& threadPool() { return *threadPoolSlot(); }
+
+inline void setNumThreads(int n) { threadPoolSlot().reset(new ThreadPool(max(n, 1))); }
+
+inline int getNumThreads() { return threadPool().size(); }
+
+// Loops whose total work (items * work per item, roughly in flops) is below the grain stay serial
+inline atomic<size_t>& parallelGrainSetting() {
+    static atomic<size_t> grain(size_t(1) << 15);
+    return grain;
+}
+
+inline void setParallelGrain(size_t grain) { parallelGrainSetting() = max<size_t>(grain, 1); }
+
+inline size_t getParallelGrain() { return parallelGrainSetting(); }
+
+// Split [begin, end) into tiles of at least one grain of work (and about four per thread)
+// and run body(lo, hi) on the pool; small loops call body(begin, end) directly.
+template <class F>
+void parallelFor(size_t begin, size_t end, size_t workPerItem, F&& body) {
+    if (begin >= end) return;
+    const size_t items = end - begin;
+    const size_t grain = getParallelGrain();
+    workPerItem = max<size_t>(workPerItem, 1);
+    if (items * workPerItem < 2 * grain || items == 1) {
+        body(begin, end);
+        return;
+    }
+    ThreadPool& pool = threadPool();
+    if (pool.size() == 1) {
+        body(begin, end);
+        return;
+    }
+    const size_t perGrain = (grain + workPerItem - 1) / workPerItem;
+    const size_t perThread = (items + 4 * pool.size() - 1) / (4 * pool.size());
+    pool.parallelFor(begin, end, max(perGrain, perThread), body);
+}
+
+#endif  // THREADPOOL_H
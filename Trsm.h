@@ -0,0 +1,126 @@
+#ifndef TRSM_H
+#define TRSM_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include "ThreadPool.h"
+#include "Gemm.h"
+
+using namespace std;
+
+// Triangular solve with many right-hand sides, op(A) * X = B, overwriting B (n x nrhs, row stride ldb) with X.
+// A is n x n and addressed through (row stride, column stride) like the GEMM operands, so the transposed
+// factor of a Cholesky decomposition is passed by swapping its strides. Only the selected triangle is read.
+// The solve is blocked: a small triangular block is solved directly (columns of B split across threads),
+// and the rows below it are updated with one GEMM, so for wide B almost all of the work is GEMM.
+
+// Rows of the triangle solved between two GEMM updates
+constexpr int trsmBlock = 64;
+
+// Below this many right-hand sides GEMM's packing costs more than it saves; plain substitution is used
+constexpr int trsmNarrow = 4;
+
+namespace trsm_detail {
+
+// Forward or backward substitution on rows [r0, r1) of B, for columns [c0, c1) only
+template <class T>
+void solveDiagonalBlock(bool lower, bool unitDiag, int r0, int r1, const T* A, ptrdiff_t rs, ptrdiff_t cs,
+                        T* B, ptrdiff_t ldb, size_t c0, size_t c1) {
+    const int first = lower ? r0 : r1 - 1;
+    const int step = lower ? 1 : -1;
+    for (int i = first; i >= r0 && i < r1; i += step) {
+        T* bi = B + i * ldb;
+        const int p0 = lower ? r0 : i + 1;
+        const int p1 = lower ? i : r1;
+        for (int p = p0; p < p1; p++) {
+            const T a = A[i * rs + p * cs];
+            if (a == T(0)) continue;
+            const T* bp = B + p * ldb;
+            for (size_t j = c0; j < c1; j++) bi[j] -= a * bp[j];
+        }
+        if (!unitDiag) {
+            const T inv = T(1) / A[i * rs + i * cs];
+            for (size_t j = c0; j < c1; j++) bi[j] *= inv;
+        }
+    }
+}
+
+// Dot product with independent partial sums, so the loop is not bound by the latency of one add chain
+template <class T>
+T dot(const T* a, const T* b, int n) {
+    T s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    int p = 0;
+    for (; p + 4 <= n; p += 4) {
+        s0 += a[p] * b[p];
+        s1 += a[p + 1] * b[p + 1];
+        s2 += a[p + 2] * b[p + 2];
+        s3 += a[p + 3] * b[p + 3];
+    }
+    for (; p < n; p++) s0 += a[p] * b[p];
+    return (s0 + s1) + (s2 + s3);
+}
+
+// Substitution over the whole triangle, one right-hand side at a time, walking A along its unit stride:
+// dot products when rows of A are contiguous, column updates (axpy) when columns are
+template <class T>
+void solveNarrow(bool lower, bool unitDiag, int n, int nrhs, const T* A, ptrdiff_t rs, ptrdiff_t cs, T* B, ptrdiff_t ldb) {
+    const int first = lower ? 0 : n - 1;
+    const int step = lower ? 1 : -1;
+    vector<T> x(n);
+    for (int c = 0; c < nrhs; c++) {
+        for (int i = 0; i < n; i++) x[i] = B[i * ldb + c];
+        for (int i = first; i >= 0 && i < n; i += step) {
+            const int p0 = lower ? 0 : i + 1;
+            const int p1 = lower ? i : n;
+            if (cs == 1) {
+                const T* ai = A + i * rs;
+                const T s = x[i] - dot(ai + p0, x.data() + p0, p1 - p0);
+                x[i] = unitDiag ? s : s / ai[i];
+            } else {
+                if (!unitDiag) x[i] /= A[i * rs + i * cs];
+                const T xi = x[i];
+                const T* ai = A + i * cs;
+                const int q0 = lower ? i + 1 : 0;
+                const int q1 = lower ? n : i;
+                for (int q = q0; q < q1; q++) x[q] -= ai[q * rs] * xi;
+            }
+        }
+        for (int i = 0; i < n; i++) B[i * ldb + c] = x[i];
+    }
+}
+
+}  // namespace trsm_detail
+
+template <class T>
+void trsm(bool lower, bool unitDiag, int n, int nrhs, const T* A, ptrdiff_t rs, ptrdiff_t cs, T* B, ptrdiff_t ldb) {
+    using namespace trsm_detail;
+    if (n <= 0 || nrhs <= 0) return;
+    if (nrhs < trsmNarrow) {
+        solveNarrow(lower, unitDiag, n, nrhs, A, rs, cs, B, ldb);
+        return;
+    }
+
+    const int blocks = (n + trsmBlock - 1) / trsmBlock;
+    for (int b = 0; b < blocks; b++) {
+        // Lower triangles are walked top-down, upper triangles bottom-up
+        const int r0 = lower ? b * trsmBlock : max(0, n - (b + 1) * trsmBlock);
+        const int r1 = lower ? min(n, r0 + trsmBlock) : n - b * trsmBlock;
+        const int nb = r1 - r0;
+        parallelFor(0, nrhs, static_cast<size_t>(nb) * nb, [=](size_t lo, size_t hi) {
+            solveDiagonalBlock(lower, unitDiag, r0, r1, A, rs, cs, B, ldb, lo, hi);
+        });
+
+        // Eliminate the solved rows from the rest of B: B_rest -= A(rest, r0:r1) * X(r0:r1)
+        const int rest0 = lower ? r1 : 0;
+        const int rest = lower ? n - r1 : r0;
+        if (rest > 0) {
+            gemm<T>(rest, nrhs, nb, T(-1),
+                    A + rest0 * rs + r0 * cs, rs, cs,
+                    B + r0 * ldb, ldb, 1,
+                    T(1), B + rest0 * ldb, ldb);
+        }
+    }
+}
+
+#endif  // TRSM_H
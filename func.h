@@ -1,6 +1,8 @@
 #ifndef FUNC_H
 #define FUNC_H
 
+#include "Fraction.h"
+
 using namespace std;
 
 // Function implementations
@@ -25,39 +27,9 @@ long long gcd(long long a, long long b) {
     return a;
 }
 
+// Same result as trying every denominator up to maxDenominator, found by walking the continued fraction
 string doubleToFraction(double value, int maxDenominator = 1000) {
-    long long bestNumerator = 0, bestDenominator = 1;
-    double bestError = abs(value);
-
-    for (int denominator = 1; denominator <= maxDenominator; ++denominator) {
-        long long numerator = round(value * denominator);
-        double error = abs(value - static_cast<double>(numerator) / denominator);
-
-        if (error < bestError) {
-            bestError = error;
-            bestNumerator = numerator;
-            bestDenominator = denominator;
-
-            // Stop early if the error is negligible
-            if (bestError < 1e-6) break;
-        }
-    }
-
-    // Simplify the fraction using the custom GCD function
-    long long divisor = gcd(bestNumerator, bestDenominator);
-    bestNumerator /= divisor;
-    bestDenominator /= divisor;
-    
-    if(bestDenominator == 1 ){
-        return to_string(bestNumerator);
-    }
-
-    if(bestDenominator < 0){
-        bestDenominator *= -1;
-        bestNumerator *= -1;
-    }
-    
-    return to_string(bestNumerator) + "/" + to_string(bestDenominator);
+    return fractionString(value, maxDenominator);
 }
 
 
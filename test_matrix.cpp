@@ -0,0 +1,974 @@
+#include <iostream>
+#include <algorithm>
+#include <iomanip>
+#include <numeric>
+#include <vector>
+#include <cmath>
+#include <string>
+#include <sstream>
+#include "func.h"
+#include "Matrix.h"
+#include "Solve.h"
+#include "SparseMatrix.h"
+#include "Spectral.h"
+#include "FixedMatrix.h"
+#include "MatrixIO.h"
+#include "Arena.h"
+#include "Strassen.h"
+
+using namespace std;
+
+// Throws so that main() reports the failing check and returns non-zero
+void check(bool condition, const string& what) {
+    if (!condition) {
+        throw runtime_error("Check failed: " + what);
+    }
+}
+
+void test_lu_determinant() {
+    cout << "=== Testing LU Determinant ===" << endl;
+
+    // Test 1: Determinant agrees with cofactor expansion
+    cout << "\n1. LU vs cofactor expansion:" << endl;
+    Matrix G({{1, 2, 1}, {3, 1, -2}, {2, -1, 4}});
+    long double lu_det = det(G);
+    long double cofactor_det = G.determinantRecursive(G.getMatrix());
+    cout << "det(G) = " << lu_det << " (Expected: " << cofactor_det << ")" << endl;
+    check(fabsl(lu_det - cofactor_det) < 1e-12L, "LU determinant of G");
+
+    // Test 2: Pivoting is needed when the leading entry is zero
+    cout << "\n2. Zero leading pivot:" << endl;
+    Matrix P({{0, 1}, {1, 0}});
+    cout << "det(P) = " << det(P) << " (Expected: -1)" << endl;
+    check(det(P) == -1, "determinant of permutation matrix");
+
+    // Test 3: Singular matrices report an exact zero
+    cout << "\n3. Singular matrix:" << endl;
+    Matrix S({{1, 2, 3}, {4, 5, 6}, {7, 8, 9}});
+    cout << "det(S) = " << det(S) << ", isSingular = " << S.isSingular() << " (Expected: 0, 1)" << endl;
+    check(det(S) == 0 && S.isSingular() && !S.isInvertible(), "singular matrix detection");
+
+    // Test 4: The factorization object reproduces P * A = L * U
+    cout << "\n4. Reusing the factorization:" << endl;
+    LUDecomposition<long double> f = G.lu();
+    Matrix L = f.getL();
+    Matrix U = f.getU();
+    Matrix PA = G;
+    for (int k = 0; k < f.size(); k++) {
+        int p = f.getPivots()[k];
+        for (int j = 0; j < PA.getCol(); j++) {
+            swap(PA(k, j), PA(p, j));
+        }
+    }
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            long double sum = 0;
+            for (int k = 0; k < 3; k++) sum += L(i, k) * U(k, j);
+            check(fabsl(sum - PA(i, j)) < 1e-12L, "P * A == L * U");
+        }
+    }
+    cout << "P * A == L * U holds, det = " << f.determinant() << endl;
+
+    // Test 5: Sizes far beyond what cofactor expansion can handle
+    cout << "\n5. Large matrix:" << endl;
+    const int n = 200;
+    MatrixD D(n, n);
+    for (int i = 0; i < n; i++) D(i, i) = 2;
+    cout << "log2(det(2 * I_200)) = " << log2(det(D)) << " (Expected: 200)" << endl;
+    check(fabs(log2(det(D)) - n) < 1e-9, "determinant of 2 * I");
+
+    // Test 6: Badly scaled but nonsingular: only an exact zero pivot makes a matrix singular
+    cout << "\n6. Badly scaled matrix:" << endl;
+    Matrix W({{1e-10L, 0}, {0, 1e10L}});
+    cout << "det(diag(1e-10, 1e10)) = " << det(W) << ", isNearlySingular = " << W.isNearlySingular()
+         << " (Expected: 1, 1)" << endl;
+    check(fabsl(det(W) - 1) < 1e-12L && W.isInvertible() && !W.isSingular(), "badly scaled determinant");
+    check(W.isNearlySingular() && fabsl(W.getinverse()(0, 0) - 1e10L) < 1e-2L, "badly scaled inverse");
+    MatrixD tiny({{1, 0, 0}, {0, 1e-200, 0}, {0, 0, 1e-200}});
+    check(tiny.isInvertible() && !tiny.isSingular() && tiny.isNearlySingular(), "tiny diagonal is invertible");
+    const MatrixD tinyInv = tiny.getinverse();
+    check(tinyInv(0, 0) == 1 && fabs(tinyInv(1, 1) / 1e200 - 1) < 1e-14 && fabs(tinyInv(2, 2) / 1e200 - 1) < 1e-14 &&
+          tinyInv(0, 1) == 0, "inverse of a tiny diagonal");
+    check(!G.isNearlySingular(), "well conditioned matrix is not nearly singular");
+}
+
+void test_inverse() {
+    cout << "\n=== Testing LU Inverse ===" << endl;
+
+    // Test 1: Inverse matches the cofactor formula adj(G) / det(G)
+    cout << "\n1. LU inverse vs adjugate:" << endl;
+    Matrix G({{1, 2, 1}, {3, 1, -2}, {2, -1, 4}});
+    Matrix H = G.getinverse();
+    Matrix adj = G.getCofMatrix().transpose() / det(G);
+    H.print();
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            check(fabsl(H(i, j) - adj(i, j)) < 1e-15L, "inverse matches adjugate");
+        }
+    }
+
+    // Test 2: A * A^-1 == I on a covariance-sized matrix that needs pivoting
+    cout << "\n2. 200x200 inverse:" << endl;
+    const int n = 200;
+    Matrix A(n, n);
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            A(i, j) = 1.0L / (1 + abs(i - j)) + (i == (j + 1) % n ? 3 : 0);
+        }
+    }
+    Matrix Ainv = A;
+    Ainv.inverse();
+    long double worst = 0;
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            long double sum = 0;
+            for (int k = 0; k < n; k++) sum += A(i, k) * Ainv(k, j);
+            worst = max(worst, fabsl(sum - (i == j ? 1 : 0)));
+        }
+    }
+    cout << "max |A * A^-1 - I| = " << worst << endl;
+    check(worst < 1e-12L, "A * A^-1 == I");
+}
+
+void test_solve() {
+    cout << "\n=== Testing Linear Solvers ===" << endl;
+
+    // Test 1: LU solve with several right-hand sides, reusing one factorization
+    cout << "\n1. LU solve with batched right-hand sides:" << endl;
+    const int n = 150;
+    MatrixD A(n, n), X(n, 20);
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) A(i, j) = 1.0 / (1 + abs(i - j)) + (i == (j + 1) % n ? 3 : 0);
+        for (int j = 0; j < 20; j++) X(i, j) = (i * 7 + j * 3) % 11 - 5;
+    }
+    MatrixD B = A * X;
+    LUDecomposition<double> f = A.lu();
+    MatrixD Y = f.solve(B);
+    double worst = 0;
+    for (int i = 0; i < n; i++) for (int j = 0; j < 20; j++) worst = max(worst, fabs(Y(i, j) - X(i, j)));
+    cout << "max |X - solve(A, A * X)| = " << worst << endl;
+    check(worst < 1e-10, "LU batched solve");
+    vector<double> b(n), x(n);
+    for (int i = 0; i < n; i++) b[i] = B(i, 3);
+    x = f.solve(b);
+    check(fabs(x[10] - X(10, 3)) < 1e-10, "LU single right-hand side");
+
+    // Test 2: Cholesky on a symmetric positive-definite system
+    cout << "\n2. Cholesky solve:" << endl;
+    Matrix S({{4, 12, -16}, {12, 37, -43}, {-16, -43, 98}});
+    CholeskyDecomposition<long double> c = cholesky(S);
+    c.getL().print();
+    Matrix rhs({{1}, {2}, {3}});
+    Matrix sol = c.solve(rhs);
+    Matrix residual = S * sol - rhs;
+    cout << "det(S) = " << c.determinant() << " (Expected: 36)" << endl;
+    check(fabsl(c.determinant() - 36) < 1e-12L, "Cholesky determinant");
+    for (int i = 0; i < 3; i++) check(fabsl(residual(i, 0)) < 1e-12L, "Cholesky residual");
+
+    // Test 3: Least-squares line fit through QR
+    cout << "\n3. QR least squares:" << endl;
+    Matrix D({{1, 0}, {1, 1}, {1, 2}, {1, 3}});
+    Matrix y({{1}, {3}, {5}, {7.5}});
+    Matrix coef = solve(D, y);
+    cout << "intercept = " << coef(0, 0) << ", slope = " << coef(1, 0) << " (Expected: 0.9, 2.15)" << endl;
+    check(fabsl(coef(0, 0) - 0.9L) < 1e-12L && fabsl(coef(1, 0) - 2.15L) < 1e-12L, "least-squares fit");
+    QRDecomposition<long double> q = qr(D);
+    Matrix QR = q.getQ() * q.getR();
+    check(fabsl(QR(3, 1) - 3) < 1e-12L, "Q * R == A");
+
+    // Test 4: Double factorization refined to long double accuracy
+    cout << "\n4. Mixed-precision solve:" << endl;
+    Matrix L(60, 60), Xt(60, 2);
+    for (int i = 0; i < 60; i++) {
+        for (int j = 0; j < 60; j++) L(i, j) = 1.0L / (1 + abs(i - j)) + (i == j ? 2 : 0) + 1e-12L * ((i * j) % 5);
+        Xt(i, 0) = 1.0L / (i + 3);
+        Xt(i, 1) = (i % 7) - 3;
+    }
+    Matrix LB = L * Xt;
+    int iterations = 0;
+    Matrix Xm = mixedPrecisionLU<double>(L).solve(LB, &iterations);
+    long double worstMixed = 0;
+    for (int i = 0; i < 60; i++) for (int j = 0; j < 2; j++) worstMixed = max(worstMixed, fabsl(Xm(i, j) - Xt(i, j)));
+    cout << "refinement steps: " << iterations << ", max error " << static_cast<double>(worstMixed) << endl;
+    check(iterations >= 1 && worstMixed < 1e-17L, "refined to long double accuracy");
+    Matrix Hilbert(14, 14);
+    for (int i = 0; i < 14; i++) for (int j = 0; j < 14; j++) Hilbert(i, j) = 1.0L / (i + j + 1);
+    mixedPrecisionLU<float>(Hilbert).solve(vector<long double>(14, 1), &iterations);
+    check(iterations == -1, "ill-conditioned systems fall back to long double LU");
+}
+
+void test_updates() {
+    cout << "\n=== Testing Inverse Updates ===" << endl;
+
+    // Largest |entry| of the difference between two inverses
+    auto diff = [](const MatrixD& X, const MatrixD& Y) {
+        double worst = 0;
+        for (int i = 0; i < X.getRow(); i++) for (int j = 0; j < X.getCol(); j++) worst = max(worst, fabs(X(i, j) - Y(i, j)));
+        return worst;
+    };
+
+    // Test 1: Element, row, column and rank-2 updates agree with inverting from scratch
+    cout << "\n1. Rank-k updates:" << endl;
+    const int n = 40;
+    MatrixD A(n, n);
+    for (int i = 0; i < n; i++) for (int j = 0; j < n; j++) A(i, j) = 1.0 / (1 + abs(i - j)) + (i == j ? 4 : 0);
+    UpdatableInverse<double> u = updatableInverse(A);
+    u.setElementAt(3, 7, 2.5);
+    vector<double> r(n), c(n);
+    for (int j = 0; j < n; j++) r[j] = (j % 5) - 2 + (j == 10 ? 6 : 0);
+    for (int i = 0; i < n; i++) c[i] = 0.5 * ((i * 3) % 7) + (i == 20 ? 6 : 0);
+    u.setRow(10, r);
+    u.setCol(20, c);
+    check(u.matrix()(3, 7) == 2.5 && u.matrix()(10, 0) == -2 && u.matrix()(0, 20) == 0, "updates applied to the matrix");
+    MatrixD U(n, 2), V(n, 2);
+    for (int i = 0; i < n; i++) {
+        U(i, 0) = 0.1 * (i % 3);
+        U(i, 1) = 0.05 * (i % 4);
+        V(i, 0) = 0.2 * ((i + 1) % 2);
+        V(i, 1) = -0.1;
+    }
+    u.update(U, V);
+    const MatrixD current = u.matrix();
+    cout << "max |inverse - getinverse()| = " << diff(u.inverse(), current.getinverse()) << endl;
+    check(diff(u.inverse(), current.getinverse()) < 1e-12, "updated inverse");
+    check(fabs(u.determinant() / det(current) - 1) < 1e-10, "updated determinant");
+    check(u.refactorizations() == 1, "well-conditioned updates need no refactorization");
+
+    // Test 2: Bordering appends a row and a column
+    cout << "\n2. Bordering:" << endl;
+    vector<double> col(n, 0.25), row(n, -0.5);
+    u.append(col, row, 7);
+    MatrixD grown = u.matrix();
+    check(grown.getRow() == n + 1 && grown(n, n) == 7 && grown(0, n) == 0.25 && grown(n, 0) == -0.5, "bordered matrix");
+    check(diff(u.inverse(), grown.getinverse()) < 1e-12, "bordered inverse");
+    check(fabs(u.determinant() / det(grown) - 1) < 1e-10, "bordered determinant");
+    vector<double> b(n + 1, 1.0), x = u.solve(b);
+    check(fabs(x[n] - grown.lu().solve(b)[n]) < 1e-12, "solve from the kept inverse");
+
+    // Test 3: Passing through a singular matrix, and refactoring after a large cancelling update
+    cout << "\n3. Singular and near-singular updates:" << endl;
+    UpdatableInverse<double> s(MatrixD({{1, 2}, {3, 4}}));
+    s.setElementAt(1, 1, 6);
+    check(s.isSingular() && s.determinant() == 0, "update to a singular matrix");
+    s.setElementAt(1, 1, 7);
+    check(!s.isSingular() && fabs(s.determinant() - 1) < 1e-12 && fabs(s.inverse()(0, 0) - 7) < 1e-12, "back to invertible");
+    UpdatableInverse<double> t(MatrixD({{2, 1, 0}, {1, 3, 1}, {0, 1, 4}}));
+    t.setElementAt(0, 0, 4.0 / 11 + 1e-13);   // det about 1e-12
+    t.setElementAt(0, 0, 2);
+    cout << "refactorizations: " << t.refactorizations() << endl;
+    check(diff(t.inverse(), t.matrix().getinverse()) < 1e-12, "drift triggers refactorization");
+}
+
+void test_spectral() {
+    cout << "\n=== Testing Eigenvalues and SVD ===" << endl;
+
+    // Test 1: Eigenpairs of a small symmetric matrix, largest first
+    cout << "\n1. Symmetric eigenvalues:" << endl;
+    Matrix C({{2, 1, 0}, {1, 2, 1}, {0, 1, 2}});
+    SymmetricEigen<long double> eig(C);
+    const vector<long double>& w = eig.eigenvalues();
+    cout << "eigenvalues = " << w[0] << ", " << w[1] << ", " << w[2] << " (Expected: 2 + sqrt(2), 2, 2 - sqrt(2))" << endl;
+    check(fabsl(w[0] - (2 + sqrtl(2))) < 1e-15L && fabsl(w[1] - 2) < 1e-15L && fabsl(w[2] - (2 - sqrtl(2))) < 1e-15L, "eigenvalues");
+    Matrix V = eig.eigenvectors();
+    Matrix CV = C * V;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) check(fabsl(CV(i, j) - w[j] * V(i, j)) < 1e-15L, "C * v == lambda * v");
+    }
+
+    // Test 2: Top-k eigenpairs agree with the full decomposition
+    cout << "\n2. Top-k eigenpairs of a 100x100 matrix:" << endl;
+    const int n = 100;
+    MatrixD S(n, n);
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) S(i, j) = 1.0 / (1 + abs(i - j)) + (i == j ? i * 0.01 : 0);
+    }
+    SymmetricEigen<double> all(S);
+    SymmetricEigen<double> top = eigenSymmetricLargest(S, 5);
+    cout << "largest = " << top.eigenvalues()[0] << " (Expected: " << all.eigenvalues()[0] << ")" << endl;
+    for (int j = 0; j < 5; j++) check(fabs(top.eigenvalues()[j] - all.eigenvalues()[j]) < 1e-12, "top-k eigenvalues");
+    MatrixD SV = S * top.eigenvectors();
+    double worst = 0;
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < 5; j++) worst = max(worst, fabs(SV(i, j) - top.eigenvalues()[j] * top.eigenvectors()(i, j)));
+    }
+    check(worst < 1e-10, "top-k eigenvectors");
+
+    // Test 3: SVD reconstructs a rectangular matrix
+    cout << "\n3. Singular value decomposition:" << endl;
+    Matrix A({{3, 2, 2}, {2, 3, -2}});
+    SVD<long double> s = svd(A);
+    cout << "singular values = " << s.singularValues()[0] << ", " << s.singularValues()[1] << " (Expected: 5, 3)" << endl;
+    check(fabsl(s.singularValues()[0] - 5) < 1e-15L && fabsl(s.singularValues()[1] - 3) < 1e-15L, "singular values");
+    Matrix U = s.getU(), W = s.getV();
+    for (int i = 0; i < 2; i++) {
+        for (int j = 0; j < 3; j++) {
+            long double sum = 0;
+            for (int k = 0; k < 2; k++) sum += U(i, k) * s.singularValues()[k] * W(j, k);
+            check(fabsl(sum - A(i, j)) < 1e-15L, "U * S * V^T == A");
+        }
+    }
+    SVD<long double> first = svdLargest(A, 1);
+    check(fabsl(first.singularValues()[0] - 5) < 1e-12L && first.singularValues().size() == 1 && s.rank() == 2,
+          "top-1 singular value and rank");
+    // An integer where the bool goes still means every value, never k of them
+    check(svd(A, 0).singularValues().size() == 2 && SymmetricEigen<long double>(A * A.transposeView(), 0).eigenvalues().size() == 2,
+          "computeVectors = 0 keeps the full decomposition");
+}
+
+void test_sparse() {
+    cout << "\n=== Testing Sparse Matrices ===" << endl;
+
+    // Test 1: COO build sums duplicates and round-trips through the dense form
+    cout << "\n1. Building from triplets:" << endl;
+    SparseBuilder<long double> builder(3, 4);
+    builder.add({{0, 1, 2}, {2, 3, 5}, {1, 0, -1}});
+    builder.add(vector<int>{2, 0}, vector<int>{3, 2}, vector<long double>{1, 7});
+    SparseMatrix S = builder.build();
+    S.toDense().print();
+    cout << "nnz = " << S.nnz() << ", S(2, 3) = " << S.getElementAt(2, 3) << " (Expected: 4, 6)" << endl;
+    check(S.nnz() == 4 && S.getElementAt(2, 3) == 6 && S.getElementAt(1, 1) == 0, "triplet build");
+    check(S.toCSC().toDense() == S.toDense(), "CSR -> CSC conversion");
+    check(S.transpose().toDense() == S.toDense().transpose(), "sparse transpose");
+
+    // Test 2: SpMV and sparse-dense products agree with the dense results, in both layouts
+    cout << "\n2. Products:" << endl;
+    const int n = 400;
+    SparseBuilder<double> tri(n, n);
+    for (int i = 0; i < n; i++) {
+        tri.add(i, i, 2);
+        if (i > 0) tri.add(i, i - 1, -1);
+        if (i + 1 < n) tri.add(i, i + 1, -1);
+    }
+    MatrixD B(n, 3);
+    vector<double> x(n);
+    for (int i = 0; i < n; i++) {
+        x[i] = i % 5;
+        for (int j = 0; j < 3; j++) B(i, j) = (i + j) % 4;
+    }
+    for (SparseFormat f : {SparseFormat::CSR, SparseFormat::CSC}) {
+        SparseMatrixD T = tri.build(f);
+        MatrixD dense = T.toDense();
+        vector<double> y = T * x;
+        MatrixD C = T * B;
+        MatrixD expected = dense * B;
+        bool ok = C == expected;
+        for (int i = 0; i < n; i++) {
+            double sum = 0;
+            for (int j = 0; j < n; j++) sum += dense(i, j) * x[j];
+            ok = ok && y[i] == sum;
+        }
+        cout << (f == SparseFormat::CSR ? "CSR" : "CSC") << ": y[1] = " << y[1] << " (Expected: 0)" << endl;
+        check(ok, "sparse products");
+    }
+}
+
+void test_multiply() {
+    cout << "\n=== Testing Matrix Multiplication ===" << endl;
+
+    // Test 1: Small product against hand-computed values
+    cout << "\n1. 2x3 * 3x2 product:" << endl;
+    Matrix A({{1, 2, 3}, {4, 5, 6}});
+    Matrix B({{7, 8}, {9, 10}, {11, 12}});
+    Matrix C = A * B;
+    C.print();
+    check(C == Matrix({{58, 64}, {139, 154}}), "2x3 * 3x2 product");
+
+    // Test 2: Blocked SIMD path with ragged edges, checked against a naive triple loop
+    cout << "\n2. Blocked product (" << gemmKernelName<double>() << " kernel):" << endl;
+    const int m = 131, n = 77, k = 301;
+    MatrixD X(m, k), Y(k, n), Z(m, n);
+    for (int i = 0; i < m; i++) for (int p = 0; p < k; p++) X(i, p) = sin(i + 0.5 * p);
+    for (int p = 0; p < k; p++) for (int j = 0; j < n; j++) Y(p, j) = cos(0.3 * p - j);
+    for (int i = 0; i < m; i++) for (int j = 0; j < n; j++) Z(i, j) = 1;
+
+    // Z = 2 * X * Y + 3 * Z, written into existing storage
+    X.multiply_into(Y, Z, 2.0, 3.0);
+    double worst = 0;
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j < n; j++) {
+            double sum = 0;
+            for (int p = 0; p < k; p++) sum += X(i, p) * Y(p, j);
+            worst = max(worst, fabs(2 * sum + 3 - Z(i, j)));
+        }
+    }
+    cout << "max error vs naive product = " << worst << endl;
+    check(worst < 1e-10, "blocked product matches naive product");
+
+    // Test 3: Strassen-Winograd with odd dimensions, a transposed operand and a tight workspace budget
+    cout << "\n3. Strassen-Winograd product:" << endl;
+    const int crossover = getStrassenCrossover();
+    setStrassenCrossover(16);
+    const MatrixD classical = X * Y;
+    const MatrixD fast = strassenMultiply(X, Y);
+    double worstFast = 0;
+    for (int i = 0; i < m; i++) for (int j = 0; j < n; j++) worstFast = max(worstFast, fabs(fast(i, j) - classical(i, j)));
+    cout << "max difference from GEMM = " << worstFast << endl;
+    check(worstFast < 1e-10, "Strassen product");
+    const MatrixD fastT = strassenMultiply(Y.transposeView(), X.transposeView());
+    check(fabs(fastT(5, 7) - classical(7, 5)) < 1e-10, "Strassen product of transposed views");
+    check(strassenMultiply(X, Y, 1024) == classical, "no workspace budget: plain GEMM");
+    setStrassenCrossover(crossover);
+}
+
+void test_expressions() {
+    cout << "\n=== Testing Fused Expressions ===" << endl;
+
+    Matrix A({{1, 2, 3}, {4, 5, 6}, {7, 8, 9}});
+    Matrix B({{9, 8, 7}, {6, 5, 4}, {3, 2, 1}});
+
+    // Test 1: A chained expression is evaluated in one pass into the destination
+    cout << "\n1. A * 2 + B / 2 - A:" << endl;
+    Matrix C = A * 2.0 + B / 2.0 - A;
+    C.print();
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            check(C(i, j) == A(i, j) + B(i, j) / 2, "fused expression value");
+        }
+    }
+
+    // Test 2: Compound assignment works in place
+    cout << "\n2. Compound assignment:" << endl;
+    Matrix D = A;
+    D += B;
+    D *= 2;
+    D -= A * 2.0;
+    D /= 2;
+    D.print();
+    check(D == B, "(2 * (A + B) - 2 * A) / 2 == B");
+
+    // Test 3: Assigning an expression that reads the destination
+    cout << "\n3. Aliased assignment A = A + A:" << endl;
+    Matrix E = A;
+    E = E + E;
+    check(E == A * 2.0, "in-place A = A + A");
+    cout << "E(2, 2) = " << E(2, 2) << " (Expected: 18)" << endl;
+
+    // Test 4: Expressions can feed a matrix product
+    cout << "\n4. (A + B) * A:" << endl;
+    Matrix F = (A + B) * A;
+    check(F == Matrix({{120, 150, 180}, {120, 150, 180}, {120, 150, 180}}), "product of an expression");
+    F.print();
+
+    // Test 5: Right-hand sides that read the destination at other positions are evaluated aside
+    cout << "\n5. Aliased views A = A^T, A += A^T:" << endl;
+    Matrix G = A;
+    G = G.transposeView();
+    G.print();
+    check(G == A.transpose(), "A = A.transposeView()");
+    MatrixD H(300, 300);
+    for (int i = 0; i < 300; i++) for (int j = 0; j < 300; j++) H(i, j) = i * 1000 + j;
+    const MatrixD Ht = H.transpose();
+    MatrixD sum = H;
+    sum = sum + sum.transposeView();
+    check(sum == H + Ht, "A = A + A.transposeView() across threads");
+    MatrixD acc = H;
+    acc += acc.transposeView();
+    acc -= acc.minorView(-1, -1) * 0.5;
+    check(acc == (H + Ht) * 0.5, "A += A.transposeView()");
+    MatrixD shifted = H;
+    const MatrixD& view = shifted;
+    shifted.block(0, 0, 299, 300) = view.block(1, 0, 299, 300);     // Rows move up by one
+    shifted.minorView(0, -1) = view.block(0, 0, 299, 300) * 1.0;    // and back down
+    check(MatrixD(shifted.minorView(0, -1)) == MatrixD(H.minorView(0, -1)) && shifted(0, 7) == H(1, 7),
+          "block and minor views shifted onto themselves");
+}
+
+void test_transpose() {
+    cout << "\n=== Testing Transpose ===" << endl;
+
+    // Test 1: Tiled transpose on a shape that is not a multiple of the tile size
+    cout << "\n1. Tiled transpose of a 70x45 matrix:" << endl;
+    MatrixD A(70, 45);
+    for (int i = 0; i < 70; i++) for (int j = 0; j < 45; j++) A(i, j) = i * 100 + j;
+    MatrixD T = A.transpose();
+    bool ok = T.getRow() == 45 && T.getCol() == 70;
+    for (int i = 0; i < 70 && ok; i++) for (int j = 0; j < 45; j++) ok = ok && T(j, i) == A(i, j);
+    cout << "T(44, 69) = " << T(44, 69) << " (Expected: 6944)" << endl;
+    check(ok, "tiled transpose");
+
+    // Test 2: In-place transpose of a square matrix
+    cout << "\n2. In-place transpose:" << endl;
+    MatrixD S(67, 67);
+    for (int i = 0; i < 67; i++) for (int j = 0; j < 67; j++) S(i, j) = i * 100 + j;
+    MatrixD expected = S.transpose();
+    S.transposeInPlace();
+    check(S == expected, "in-place transpose");
+    cout << "S(0, 66) = " << S(0, 66) << " (Expected: 6600)" << endl;
+
+    // Test 3: Lazy transposed view feeds GEMM and expressions without materializing
+    cout << "\n3. Transposed view:" << endl;
+    MatrixD gram = A.transposeView() * A;
+    MatrixD reference = T * A;
+    double worst = 0;
+    for (int i = 0; i < 45; i++) for (int j = 0; j < 45; j++) worst = max(worst, fabs(gram(i, j) - reference(i, j)));
+    cout << "max |A^T A (view) - A^T A (copy)| = " << worst << endl;
+    check(worst == 0, "GEMM with a transposed view");
+    MatrixD sym = S + S.transposeView();
+    check(sym == sym.transpose(), "S + S^T is symmetric");
+}
+
+void test_views() {
+    cout << "\n=== Testing Block Views ===" << endl;
+
+    // Test 1: Writes through a block reach the parent matrix
+    cout << "\n1. Writing through a block:" << endl;
+    Matrix A({{1, 2, 3, 4}, {5, 6, 7, 8}, {9, 10, 11, 12}});
+    A.block(1, 1, 2, 2) = A.block(1, 1, 2, 2) * 10.0L;
+    A.block(0, 0, 1, 4) += A.rowRange(2, 3);
+    A.print();
+    check(A(1, 1) == 60 && A(2, 2) == 110 && A(0, 3) == 16 && A(0, 0) == 10, "block assignment");
+    A.colRange(3, 4).fill(0);
+    check(A(1, 3) == 0 && A(2, 3) == 0, "column range fill");
+
+    // Test 2: Minor views match getSubMatrix and feed products without copies
+    cout << "\n2. Minor view:" << endl;
+    Matrix G({{1, 2, 1}, {3, 1, -2}, {2, -1, 4}});
+    check(Matrix(G.minorView(1, 2)) == G.getSubMatrix(1, 2), "minor view matches getSubMatrix");
+    cout << "det(G without row 0, col 0) = " << det(Matrix(G.minorView(0, 0))) << " (Expected: 2)" << endl;
+    Matrix P = G.minorView(-1, 0) * G.block(0, 0, 2, 2);
+    P.print();
+    check(P == Matrix({{5, 5}, {-5, 0}, {11, 2}}), "product with views");
+
+    // Test 3: Products and solves written straight into blocks of a larger matrix
+    cout << "\n3. GEMM and solve into blocks:" << endl;
+    MatrixD S({{4, 1, 0}, {1, 3, 1}, {0, 1, 2}});
+    MatrixD work(5, 6);
+    multiply_into(S, MatrixD({{1}, {2}, {3}}), work.block(1, 2, 3, 1));
+    cout << "S * [1 2 3]^T = " << work(1, 2) << ", " << work(2, 2) << ", " << work(3, 2) << " (Expected: 6, 10, 8)" << endl;
+    check(work(1, 2) == 6 && work(2, 2) == 10 && work(3, 2) == 8, "multiply_into a block");
+    cholesky(S).solveInPlace(work.block(1, 2, 3, 1));
+    check(fabs(work(1, 2) - 1) < 1e-14 && fabs(work(3, 2) - 3) < 1e-14 && work(0, 2) == 0, "solve in a block");
+    MatrixD y = solve(S.block(0, 0, 3, 3), S * work.block(1, 2, 3, 1));
+    check(fabs(y(1, 0) - 2) < 1e-14, "solve with view operands");
+}
+
+void test_fixed() {
+    cout << "\n=== Testing Fixed-Size Matrices ===" << endl;
+
+    // Test 1: Compile-time shapes, evaluated at compile time
+    cout << "\n1. Constexpr arithmetic:" << endl;
+    constexpr Matrix2 a({{1, 2}, {3, 4}});
+    static_assert(a.determinant() == -2, "2x2 determinant");
+    static_assert((a * a)(1, 1) == 22, "2x2 product");
+    static_assert((a * a.inverse())(0, 1) == 0, "2x2 inverse");
+    cout << "det = " << a.determinant() << " (Expected: -2)" << endl;
+    check(a.toMatrix() == MatrixD({{1, 2}, {3, 4}}), "conversion to BasicMatrix");
+
+    // Test 2: Closed forms agree with the LU path
+    cout << "\n2. Determinant and inverse:" << endl;
+    Matrix4 m({{4, 1, 0, 2}, {1, 3, 1, 0}, {0, 1, 2, 1}, {2, 0, 1, 5}});
+    MatrixD md = m.toMatrix();
+    cout << "det = " << m.determinant() << " (LU: " << det(md) << ")" << endl;
+    check(fabs(m.determinant() - det(md)) < 1e-12, "4x4 determinant");
+    Matrix4 r = m * m.inverse() - Matrix4::identity();
+    check(*max_element(r.data(), r.data() + 16, [](double x, double y) { return fabs(x) < fabs(y); }) < 1e-14,
+          "4x4 inverse");
+    FixedMatrix<double, 5, 5> big(MatrixD({{2, 1, 0, 0, 0}, {1, 2, 1, 0, 0}, {0, 1, 2, 1, 0}, {0, 0, 1, 2, 1}, {0, 0, 0, 1, 2}}));
+    check(fabs(big.determinant() - 6) < 1e-12 && fabs((big * big.inverse())(4, 4) - 1) < 1e-14, "5x5 fallback");
+
+    // Test 3: Batches, including a tail shorter than one SIMD pack and a singular member
+    cout << "\n3. Batched operations:" << endl;
+    size_t n = 37;
+    FixedMatrixBatch<double, 3, 3> batch(n);
+    FixedMatrixBatch<double, 3, 1> points(n);
+    for (size_t b = 0; b < n; b++) {
+        double s = static_cast<double>(b) + 1;
+        batch.set(b, Matrix3({{s, 1, 0}, {0, 2, 1}, {1, 0, 3}}));
+        points.set(b, FixedMatrix<double, 3, 1>({{s}, {0}, {1}}));
+    }
+    vector<double> dets = batch.determinants();
+    FixedMatrixBatch<double, 3, 3> inv = batch.inverse();
+    FixedMatrixBatch<double, 3, 1> moved = batch * points;
+    FixedMatrixBatch<double, 3, 1> shifted = Matrix3::identity() * 2.0 * points;
+    bool ok = true;
+    for (size_t b = 0; b < n; b++) {
+        ok = ok && fabs(dets[b] - batch.get(b).determinant()) < 1e-12;
+        Matrix3 e = batch.get(b) * inv.get(b) - Matrix3::identity();
+        ok = ok && fabs(*max_element(e.data(), e.data() + 9, [](double x, double y) { return fabs(x) < fabs(y); })) < 1e-14;
+        ok = ok && moved.get(b) == batch.get(b) * points.get(b) && shifted.get(b)(0, 0) == 2.0 * points.get(b)(0, 0);
+    }
+    cout << "det(batch[36]) = " << dets[36] << " (Expected: " << 6 * 37 + 1 << ")" << endl;
+    check(ok, "batch matches element-wise results");
+    batch.set(20, Matrix3());
+    vector<char> singular;
+    inv = batch.tryInverse(singular);
+    check(singular[20] == 1 && count(singular.begin(), singular.end(), 1) == 1 && inv.get(20) == Matrix3(),
+          "singular member flagged");
+}
+
+void test_binary_io() {
+    cout << "\n=== Testing Binary Files and Mapped Matrices ===" << endl;
+
+    // Test 1: Bulk save and load, with and without element type conversion
+    cout << "\n1. Save and load:" << endl;
+    MatrixD A(90, 70), B(70, 50);
+    for (int i = 0; i < 90; i++) for (int j = 0; j < 70; j++) A(i, j) = sin(i * 0.3 + j * 0.7);
+    for (int i = 0; i < 70; i++) for (int j = 0; j < 50; j++) B(i, j) = cos(i * 0.5 - j * 0.2);
+    saveMatrix(A, "test_A.cmat");
+    saveMatrix(B, "test_B.cmat");
+    check(loadMatrix<double>("test_A.cmat") == A, "binary round trip");
+    Matrix wide = loadMatrix<long double>("test_A.cmat");
+    check(wide(89, 69) == static_cast<long double>(A(89, 69)), "load with conversion");
+
+    // Test 2: Tiled products and transposes through mapped files, with a budget far below the data
+    cout << "\n2. Out-of-core multiply and transpose:" << endl;
+    {
+        MappedMatrix<double> MA = MappedMatrix<double>::open("test_A.cmat");
+        MappedMatrix<double> MB = MappedMatrix<double>::open("test_B.cmat");
+        MappedMatrix<double> MC = MappedMatrix<double>::create("test_C.cmat", 90, 50);
+        MappedMatrix<double> MT = MappedMatrix<double>::create("test_T.cmat", 70, 90);
+        multiplyOutOfCore(MA, MB, MC, 16 * 1024);
+        transposeOutOfCore(MA, MT, 16 * 1024);
+        MatrixD C = A * B, diff = MC.toMatrix() - C;
+        double err = 0;
+        for (int i = 0; i < 90; i++) for (int j = 0; j < 50; j++) err = max(err, fabs(diff(i, j)));
+        cout << "max |C - A*B| = " << err << endl;
+        check(err < 1e-12, "out-of-core multiply");
+        check(MT.toMatrix() == A.transpose(), "out-of-core transpose");
+
+        // Writes through a shared mapping reach the file; a private mapping keeps them to itself
+        MC.block(0, 0, 2, 2) = MA.block(0, 0, 2, 2) * 2.0;
+        MA(0, 0) = 100;
+        MC.flush();
+
+        // Paging hints keep in-memory changes to a private mapping, and a private product is refused
+        MA.block(10, 0, 50, 70).fill(7);
+        MA.doneWith(0, 90);
+        check(MA(0, 0) == 100 && MA(30, 5) == 7 && MA(59, 69) == 7, "doneWith keeps private changes");
+        MappedMatrix<double> privateC = MappedMatrix<double>::open("test_C.cmat");
+        bool threw = false;
+        try {
+            multiplyOutOfCore(MA, MB, privateC, 16 * 1024);
+        } catch (const invalid_argument& e) {
+            cout << "Expected error: " << e.what() << endl;
+            threw = true;
+        }
+        check(threw, "out-of-core product into a private mapping must throw");
+    }
+    check(loadMatrix<double>("test_C.cmat")(1, 1) == 2 * A(1, 1), "write through mapping");
+    check(loadMatrix<double>("test_A.cmat")(0, 0) == A(0, 0), "private mapping leaves the file alone");
+    for (const char* f : {"test_A.cmat", "test_B.cmat", "test_C.cmat", "test_T.cmat"}) remove(f);
+}
+
+void test_print() {
+    cout << "\n=== Testing Printing ===" << endl;
+
+    // Test 1: The continued-fraction search agrees with the definition
+    cout << "\n1. Fractions:" << endl;
+    check(fractionString(1.33333) == "4/3" && fractionString(-0.5) == "-1/2" && fractionString(2.0) == "2", "simple fractions");
+    check(fractionString(3.14159265358979) == "355/113", "closest fraction when none is within tolerance");
+    check(fractionString(1.0 / 1001) == "1/1000" && fractionString(0.0004) == "0", "denominator limit");
+
+    // Test 2: The buffered table has the same layout print() always had
+    cout << "\n2. Buffered table:" << endl;
+    Matrix A({{0.5, -1.0L / 3}, {2, 22.0L / 7}});
+    ostringstream os;
+    A.print(os);
+    const string expected =
+        "+---------------------------+\n"
+        "|     1/2     |    -1/3     | \n"
+        "+---------------------------+\n"
+        "|       2     |    22/7     | \n"
+        "+---------------------------+\n\n";
+    cout << os.str();
+    check(os.str() == expected && A.toString() == expected, "table layout");
+}
+
+void test_growth() {
+    cout << "\n=== Testing Row and Column Growth ===" << endl;
+
+    // Test 1: Column appends go into spare capacity; every operation honours the row stride
+    cout << "\n1. Column capacity:" << endl;
+    MatrixD D(3, 1);
+    for (int j = 1; j <= 8; j++) {
+        vector<double> c = {double(j), double(j * j), 1};
+        D.add_col(c);
+    }
+    cout << "9 columns, row stride " << D.getLd() << endl;
+    check(D.getLd() >= D.getCol() && D(1, 3) == 9 && D(2, 8) == 1, "add_col keeps elements");
+    MatrixD packed = D;
+    check(packed.getLd() == 9 && packed == D, "copies are packed");
+    check(D * D.transpose() == packed * packed.transpose() && D.transpose() == packed.transpose(), "products and transposes");
+    D.shrink_to_fit();
+    check(D.getLd() == D.getCol() && D == packed, "shrink_to_fit");
+
+    // Test 2: Block appends, including blocks that read the matrix being grown
+    cout << "\n2. Block appends:" << endl;
+    MatrixD X;
+    X.reserve(8, 8);
+    X.append_cols(MatrixD({{1, 2}, {3, 4}}));
+    X.append_rows(X * 10.0);
+    X.append_cols(X.colRange(0, 1));
+    X.print();
+    check(X.getRow() == 4 && X.getCol() == 3 && X.getLd() == 8, "block appends within capacity");
+    check(X(3, 1) == 40 && X(2, 2) == 10 && X(1, 2) == 3, "appended values");
+    X.append_cols(X);
+    check(X.getCol() == 6 && X(3, 5) == 30 && X(0, 3) == 1, "self append past capacity");
+}
+
+void test_arena() {
+    cout << "\n=== Testing Arena Allocation ===" << endl;
+
+    // Test 1: Matrices created inside a scope come from the arena; results agree with heap ones
+    cout << "\n1. Arena scope:" << endl;
+    MatrixD A({{4, 1, 2}, {1, 5, 3}, {2, 3, 6}});
+    MatrixD B({{1, 0, 2}, {0, 1, 1}, {3, 1, 0}});
+    const MatrixD expected = A * B + A.transpose();
+    MatrixArena arena;
+    MatrixD kept;
+    {
+        ArenaScope scope(arena);
+        MatrixD C = A * B + A.transpose();
+        check(C.getArena() == &arena && A.getArena() == nullptr, "temporaries use the arena");
+        check(C == expected, "arena result");
+        kept = C;                                 // kept was made outside: stays on the heap
+        check(kept.getArena() == nullptr && kept == expected, "copy assignment keeps the target's storage");
+        MatrixD moved = [] { ArenaScope heap; return MatrixD(3, 3); }();
+        check(moved.getArena() == nullptr, "default scope switches to the heap");
+        const double* buffer = C.data();
+        moved = std::move(C);                     // Takes the arena buffer without copying
+        check(moved.getArena() == &arena && moved.data() == buffer, "move assignment takes the source's arena");
+        MatrixD inv = withArena(arena, [&] { return A.getinverse(); });
+        check(inv.getArena() == &arena, "withArena");
+    }
+    cout << "arena used " << arena.used() << " of " << arena.capacity() << " bytes" << endl;
+    arena.reset();                                // Every matrix from the arena is gone, so this cannot throw
+    check(arena.used() == 0 && arena.capacity() > 0, "reset keeps the memory");
+
+    // Test 2: Freeing in one step, and rewinding to a mark
+    cout << "\n2. Reset and rewind:" << endl;
+    const MatrixD cofactors = A.getCofMatrix();
+    ArenaScope scope(arena);
+    MatrixD live(4, 4);
+    const MatrixArena::Mark mark = arena.mark();
+    for (int k = 0; k < 100; k++) {
+        MatrixD t = A * B;
+    }
+    arena.rewind(mark);
+    bool threw = false;
+    try {
+        arena.reset();
+    } catch (const runtime_error& e) {
+        cout << "Expected error: " << e.what() << endl;
+        threw = true;
+    }
+    check(threw, "reset with live matrices must throw");
+    check(arena.used() == mark.used, "rewind frees what came after the mark");
+    check(A.getCofMatrix(arena) == cofactors, "getCofMatrix with a scratch arena");
+
+    // Test 3: Freeing a matrix from before the mark does not make up for one still alive after it
+    cout << "\n3. Rewind with a live matrix after the mark:" << endl;
+    MatrixArena other;
+    ArenaScope otherScope(other);
+    unique_ptr<MatrixD> before = make_unique<MatrixD>(8, 8);
+    const MatrixArena::Mark otherMark = other.mark();
+    MatrixD after(8, 8);
+    before.reset();
+    threw = false;
+    try {
+        other.rewind(otherMark);
+    } catch (const runtime_error& e) {
+        cout << "Expected error: " << e.what() << endl;
+        threw = true;
+    }
+    check(threw, "rewind past a live matrix must throw");
+}
+
+void test_value_semantics() {
+    cout << "\n=== Testing Value Semantics and Views ===" << endl;
+
+    // Test 1: Moving steals the buffer and leaves an empty matrix behind
+    cout << "\n1. Move construction:" << endl;
+    Matrix A({{1, 2}, {3, 4}});
+    const long double* buffer = A.data();
+    Matrix B(std::move(A));
+    cout << "B is " << B.getRow() << "x" << B.getCol() << ", moved-from A is " << A.getRow() << "x" << A.getCol() << endl;
+    check(B.data() == buffer && A.getRow() == 0 && A.getCol() == 0, "move constructor steals the buffer");
+    static_assert(is_nothrow_move_constructible<Matrix>::value && is_nothrow_move_assignable<Matrix>::value,
+                  "Matrix moves must not throw");
+
+    // Test 2: Assignment adopts the shape of the right-hand side
+    cout << "\n2. Resizing assignment:" << endl;
+    Matrix C(3, 3);
+    C = B;
+    check(C.getRow() == 2 && C.getCol() == 2 && C == B, "copy assignment resizes");
+    Matrix D(1, 1);
+    D = B * 2.0;
+    check(D.getRow() == 2 && D(1, 1) == 8, "expression assignment resizes");
+    cout << "C is " << C.getRow() << "x" << C.getCol() << ", D(1, 1) = " << D(1, 1) << " (Expected: 8)" << endl;
+
+    // Test 3: Row and data views read and write the matrix without copying it
+    cout << "\n3. Row and data views:" << endl;
+    Span<long double> second = B.rowView(1);
+    second[0] = 30;
+    long double total = 0;
+    for (long double v : B.dataView()) total += v;
+    cout << "B(1, 0) = " << B(1, 0) << ", sum = " << total << " (Expected: 30, 37)" << endl;
+    check(B(1, 0) == 30 && total == 37, "views alias the matrix");
+}
+
+void test_parallel() {
+    cout << "\n=== Testing Parallel Execution ===" << endl;
+
+    const int n = 300;
+    MatrixD A(n, n);
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            A(i, j) = sin(1.0 + i * n + j) + (i == j ? 10 : 0);
+        }
+    }
+
+    // Reference results with a single thread
+    setNumThreads(1);
+    MatrixD product = A * A;
+    MatrixD inverse = A.getinverse();
+    MatrixD sum = A + A.transpose();
+    double determinant = det(A);
+
+    // Same operations on four threads with a tiny grain so every loop is split into tiles
+    setNumThreads(4);
+    setParallelGrain(64);
+    cout << "threads = " << getNumThreads() << ", grain = " << getParallelGrain() << endl;
+    MatrixD product4 = A * A;
+    MatrixD inverse4 = A.getinverse();
+    MatrixD sum4 = A + A.transpose();
+    double determinant4 = det(A);
+
+    double worst = 0;
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            worst = max(worst, fabs(product(i, j) - product4(i, j)));
+            worst = max(worst, fabs(inverse(i, j) - inverse4(i, j)));
+            worst = max(worst, fabs(sum(i, j) - sum4(i, j)));
+        }
+    }
+    cout << "max difference serial vs parallel = " << worst << endl;
+    cout << "det serial = " << determinant << ", det parallel = " << determinant4 << endl;
+    check(worst < 1e-12, "parallel results match serial results");
+    check(fabs(determinant - determinant4) <= 1e-12 * fabs(determinant), "parallel determinant");
+
+    // Exceptions thrown inside a tile reach the caller
+    bool threw = false;
+    try {
+        parallelFor(0, 1000, 1000, [](size_t lo, size_t) {
+            if (lo > 0) throw runtime_error("tile failed");
+        });
+    } catch (const runtime_error& e) {
+        cout << "Exception from worker: " << e.what() << endl;
+        threw = true;
+    }
+    check(threw, "exceptions propagate out of parallelFor");
+
+    setParallelGrain(size_t(1) << 15);
+}
+
+void test_error_cases() {
+    cout << "\n=== Testing Error Cases ===" << endl;
+
+    bool threw = false;
+    try {
+        Matrix R(2, 3);
+        cout << "Trying to take the determinant of a 2x3 matrix" << endl;
+        det(R);  // Should throw error
+    } catch (const invalid_argument& e) {
+        cout << "Expected error: " << e.what() << endl;
+        threw = true;
+    }
+    check(threw, "non-square determinant must throw");
+
+    threw = false;
+    try {
+        Matrix S({{1, 2}, {2, 4}});
+        cout << "Trying to invert a singular matrix" << endl;
+        S.getinverse();  // Should throw error
+    } catch (const runtime_error& e) {
+        cout << "Expected error: " << e.what() << endl;
+        threw = true;
+    }
+    check(threw, "singular inverse must throw");
+
+    threw = false;
+    try {
+        Matrix A(2, 3), B(2, 3);
+        cout << "Trying to multiply 2x3 by 2x3" << endl;
+        A * B;  // Should throw error
+    } catch (const runtime_error& e) {
+        cout << "Expected error: " << e.what() << endl;
+        threw = true;
+    }
+    check(threw, "mismatched product must throw");
+
+    threw = false;
+    try {
+        Matrix A(2, 2), B(3, 3);
+        cout << "Trying to subtract 3x3 from 2x2" << endl;
+        Matrix C = A - B;  // Should throw error
+    } catch (const runtime_error& e) {
+        cout << "Expected error: " << e.what() << endl;
+        threw = true;
+    }
+    check(threw, "mismatched subtraction must throw");
+
+    threw = false;
+    try {
+        Matrix A({{1, 2}, {2, 1}});
+        cout << "Trying a Cholesky decomposition of an indefinite matrix" << endl;
+        cholesky(A);  // Should throw error
+    } catch (const runtime_error& e) {
+        cout << "Expected error: " << e.what() << endl;
+        threw = true;
+    }
+    check(threw, "indefinite Cholesky must throw");
+
+    threw = false;
+    try {
+        FixedMatrixBatch<double, 2, 2> batch(3);
+        batch.set(0, Matrix2::identity());
+        cout << "Trying to invert a batch with a singular member" << endl;
+        batch.inverse();  // Should throw error
+    } catch (const runtime_error& e) {
+        cout << "Expected error: " << e.what() << endl;
+        threw = true;
+    }
+    check(threw, "singular batch inverse must throw");
+
+    threw = false;
+    try {
+        cout << "Trying to load a file that is not a matrix file" << endl;
+        loadMatrix<double>("test_matrix.cpp");  // Should throw error
+    } catch (const runtime_error& e) {
+        cout << "Expected error: " << e.what() << endl;
+        threw = true;
+    }
+    check(threw, "loading a non-matrix file must throw");
+}
+
+int main() {
+    try {
+        test_lu_determinant();
+        test_inverse();
+        test_solve();
+        test_updates();
+        test_spectral();
+        test_sparse();
+        test_multiply();
+        test_expressions();
+        test_transpose();
+        test_views();
+        test_fixed();
+        test_binary_io();
+        test_print();
+        test_growth();
+        test_arena();
+        test_value_semantics();
+        test_parallel();
+        cout << "\n=== All tests completed! ===" << endl;
+        test_error_cases();
+    }
+    catch (const exception& e) {
+        cout << "Unexpected error: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <cmath>
 #include "Tensor.h"
 
 using namespace std;
@@ -141,10 +142,260 @@ void test_error_cases() {
     }
 }
 
+void test_views() {
+    cout << "\n=== Testing Shared Storage and Views ===" << endl;
+
+    // Squeeze, unsqueeze and view share the buffer with their source
+    cout << "\n1. Writes through a view:" << endl;
+    Tensor<double> t({2, 1, 3}, 0.0);
+    Tensor<double> sq = t.squeeze();
+    Tensor<double> col = t.view({6, 1});
+    sq.at({1, 2}) = 4.0;
+    *(col.begin() + 1) = 2.0;
+    cout << "Original after writes: " << t << endl;
+    cout << "Shares storage: " << boolalpha << (t.shares_storage(sq) && t.shares_storage(col)) << endl;
+
+    // A view keeps the buffer alive after its source is gone
+    cout << "\n2. View outliving its source:" << endl;
+    Tensor<double> row;
+    {
+        Tensor<double> tmp({3}, 1.5);
+        row = tmp.unsqueeze(0);
+    }
+    cout << "Unsqueezed view: " << row << endl;
+
+    // clone() gives an independent buffer
+    cout << "\n3. clone():" << endl;
+    Tensor<double> copy = t.clone();
+    copy.fill(9.0);
+    cout << "Clone after fill: " << copy << endl;
+    cout << "Original unchanged: " << t << endl;
+    cout << "Shares storage: " << (t.shares_storage(copy)) << noboolalpha << endl;
+
+    try {
+        cout << "\n4. view() with a different element count:" << endl;
+        auto bad = t.view({4, 2});
+    } catch (const exception& e) {
+        cout << "Expected error: " << e.what() << endl;
+    }
+}
+
+void test_slicing() {
+    cout << "\n=== Testing Strided Slicing ===" << endl;
+
+    vector<double> values(24);
+    for (size_t i = 0; i < values.size(); ++i) values[i] = static_cast<double>(i);
+    Tensor<double> t(values, {2, 3, 4});
+    cout << "Source: " << t << endl;
+
+    // Every other column of rows 1..2 of both matrices
+    cout << "\n1. Multi-dimensional slice:" << endl;
+    Tensor<double> s = t[{Range(0, 2), Range(1, 3), Range(0, 4, 2)}];
+    cout << "t[{0:2, 1:3, 0:4:2}]: " << s << endl;
+    cout << "Offset " << s.offset() << ", contiguous: " << boolalpha << s.is_contiguous() << endl;
+
+    // Slices are views: writes reach the source
+    cout << "\n2. Writing through a slice:" << endl;
+    Tensor<double> plane = t.slice(0, Range(1, 2));
+    plane.fill(-1.0);
+    cout << "Source after filling t[1]: " << t << endl;
+
+    // contiguous() packs a strided view, and returns a contiguous one as is
+    cout << "\n3. contiguous():" << endl;
+    Tensor<double> packed = s.contiguous();
+    cout << "Packed: " << packed << endl;
+    cout << "Packed shares storage: " << packed.shares_storage(t)
+         << ", contiguous row shares storage: " << t[{Range(0, 1)}].contiguous().shares_storage(t) << endl;
+
+    // A transpose is copied tile by tile
+    cout << "\n4. Transposed view:" << endl;
+    Tensor<double> m(vector<double>(values.begin(), values.begin() + 6), {2, 3});
+    Tensor<double> mt = m.transpose(0, 1);
+    cout << "Transpose: " << mt << endl;
+    cout << "Element (2, 1): " << mt.at({2, 1}) << ", packed: " << mt.contiguous() << noboolalpha << endl;
+
+    try {
+        cout << "\n5. Iterating a strided view:" << endl;
+        auto it = mt.begin();
+        (void)it;
+    } catch (const exception& e) {
+        cout << "Expected error: " << e.what() << endl;
+    }
+
+    try {
+        cout << "\n6. Slice out of bounds:" << endl;
+        auto bad = t.slice(2, Range(3, 5));
+    } catch (const exception& e) {
+        cout << "Expected error: " << e.what() << endl;
+    }
+}
+
+void test_arithmetic() {
+    cout << "\n=== Testing Element-wise Arithmetic ===" << endl;
+
+    Tensor<double> m(vector<double>{1, 2, 3, 4, 5, 6}, {2, 3});
+    Tensor<double> row({3}, 0.0);
+    row.at({0}) = 10.0;
+    row.at({2}) = -1.0;
+    Tensor<double> col(vector<double>{1, 2}, {2, 1});
+
+    // Broadcasting a row, a column and a scalar
+    cout << "\n1. Broadcasting:" << endl;
+    cout << "m + row: " << (m + row) << endl;
+    cout << "m * col: " << (m * col) << endl;
+    cout << "col - row: " << (col - row) << endl;
+    cout << "1 / m: " << (1.0 / m) << endl;
+
+    // Comparisons give 0/1 masks that can scale other tensors
+    cout << "\n2. Comparisons and fma:" << endl;
+    cout << "m > 3: " << (m > 3.0) << endl;
+    cout << "m == m.T.T: " << (m == m.transpose(0, 1).transpose(0, 1)) << endl;
+    cout << "fma(m, col, row): " << fma(m, col, row) << endl;
+
+    // Unary functions and a strided operand
+    cout << "\n3. Unary functions:" << endl;
+    Tensor<double> small(vector<double>{0.0, 1.0}, {2});
+    cout << "exp: " << exp(small) << endl;
+    cout << "log(exp): " << log(exp(small)) << endl;
+    cout << "tanh(0): " << tanh(small).at({0}) << ", -abs: " << -abs(small - 2.0) << endl;
+    cout << "sqrt of a transposed view: " << sqrt(m.transpose(0, 1)) << endl;
+
+    // Compound assignment writes through a view into its source
+    cout << "\n4. Compound assignment:" << endl;
+    Tensor<double> first_col = m.slice(1, Range(0, 1));
+    first_col *= col;
+    first_col += 0.5;
+    cout << "m after first column *= col, += 0.5: " << m << endl;
+    Tensor<double> sq(vector<double>{1, 2, 3, 4, 5, 6, 7, 8, 9}, {3, 3});
+    sq += sq.transpose(0, 1);
+    cout << "sq += sq.T (symmetric): " << sq << endl;
+
+    // Long rows take the SIMD loops and large tensors the thread pool; every element is checked
+    // against a plain scalar loop
+    cout << "\n5. Long rows and large tensors against scalar loops:" << endl;
+    const size_t R = 257, C = 300;  // 77100 elements: above the parallel grain, rows not a multiple of 8
+    Tensor<double> big({R, C}, 0.0), brow({C}, 0.0), bcol({R, 1}, 0.0);
+    double* pb = big.data();
+    for (size_t i = 0; i < R * C; ++i) pb[i] = std::sin(0.37 * static_cast<double>(i)) + 1.5;
+    for (size_t j = 0; j < C; ++j) brow.data()[j] = 0.25 * static_cast<double>(j) - 30.0;
+    for (size_t i = 0; i < R; ++i) bcol.data()[i] = 1.0 + static_cast<double>(i % 7);
+    const Tensor<double> sum = big + brow, prod = big * bcol, fused = fma(big, bcol, brow);
+    const Tensor<double> quot = 3.0 / big, mask = big > brow, root = sqrt(big);
+    const Tensor<double> bigT = big.transpose(0, 1), viaT = bigT + bigT;  // Strided inner loop
+    Tensor<double> acc = big.clone();
+    acc -= brow;
+    acc *= 0.5;
+    size_t checked = 0, mismatches = 0;
+    auto expect = [&](double got, double want) {
+        ++checked;
+        if (got != want) ++mismatches;
+    };
+    for (size_t i = 0; i < R; ++i) {
+        for (size_t j = 0; j < C; ++j) {
+            const double x = pb[i * C + j], r = brow.data()[j], c = bcol.data()[i];
+            expect(sum.data()[i * C + j], x + r);
+            expect(prod.data()[i * C + j], x * c);
+            expect(fused.data()[i * C + j], std::fma(x, c, r));
+            expect(quot.data()[i * C + j], 3.0 / x);
+            expect(mask.data()[i * C + j], x > r ? 1.0 : 0.0);
+            expect(root.data()[i * C + j], std::sqrt(x));
+            expect(viaT.data()[j * R + i], x + x);
+            expect(acc.data()[i * C + j], (x - r) * 0.5);
+        }
+    }
+    Tensor<float> line({100003}, 0.0f);  // One long row, split into ranges across threads
+    for (size_t i = 0; i < line.size(); ++i) line.data()[i] = static_cast<float>(i % 1000) * 0.5f;
+    const Tensor<float> line2 = line * line - 1.0f;
+    for (size_t i = 0; i < line.size(); ++i) {
+        const float x = line.data()[i];
+        ++checked;
+        if (line2.data()[i] != x * x - 1.0f) ++mismatches;
+    }
+    cout << "checked " << checked << " elements, mismatches: " << mismatches << " (Expected: 0)" << endl;
+
+    try {
+        cout << "\n6. Incompatible shapes:" << endl;
+        auto bad = m + Tensor<double>({2}, 1.0);
+    } catch (const exception& e) {
+        cout << "Expected error: " << e.what() << endl;
+    }
+
+    try {
+        cout << "\n7. Compound assignment that would grow the tensor:" << endl;
+        row += m;
+    } catch (const exception& e) {
+        cout << "Expected error: " << e.what() << endl;
+    }
+}
+
+void test_indexing() {
+    cout << "\n=== Testing Element Access ===" << endl;
+
+    Tensor<int> t({2, 3, 4}, 0);
+    for (size_t i = 0; i < 2; ++i)
+        for (size_t j = 0; j < 3; ++j)
+            for (size_t k = 0; k < 4; ++k)
+                t.unchecked(i, j, k) = static_cast<int>(100 * i + 10 * j + k);
+
+    // operator(), unchecked() and data() with strides address the same element, also in a view
+    cout << "\n1. Three ways to one element:" << endl;
+    Tensor<int> v = t.transpose(0, 2).slice(1, Range(1, 3));
+    const int* p = v.data();
+    cout << "v(3, 0, 1) = " << v(3, 0, 1) << ", unchecked = " << v.unchecked(3, 0, 1)
+         << ", data() = " << p[3 * v.strides()[0] + 0 * v.strides()[1] + 1 * v.strides()[2]] << endl;
+
+    try {
+        cout << "\n2. Wrong number of indices:" << endl;
+        t(1, 2) = 0;
+    } catch (const exception& e) {
+        cout << "Expected error: " << e.what() << endl;
+    }
+
+    try {
+        cout << "\n3. Index out of bounds:" << endl;
+        t(1, 3, 0) = 0;
+    } catch (const exception& e) {
+        cout << "Expected error: " << e.what() << endl;
+    }
+
+    try {
+        cout << "\n4. Indexing a default-constructed tensor:" << endl;
+        Tensor<int> none;
+        none.at({0}) = 0;
+    } catch (const exception& e) {
+        cout << "Expected error: " << e.what() << endl;
+    }
+}
+
+void test_metadata() {
+    cout << "\n=== Testing Shape Metadata ===" << endl;
+
+    // Shapes of up to 8 dimensions stay inline; more spill to the heap
+    cout << "\n1. Inline and heap shapes:" << endl;
+    Tensor<double> small({2, 3, 4}, 1.0);
+    Tensor<double> deep(vector<size_t>(10, 1), 2.0);
+    cout << "3-D shape inline: " << boolalpha << small.shape().is_inline()
+         << ", 10-D shape inline: " << deep.shape().is_inline() << endl;
+    cout << "10-D tensor squeezed: " << deep.squeeze() << endl;
+    cout << "Unsqueezed to 11-D: " << deep.unsqueeze(10).ndim() << " dimensions" << endl;
+
+    // Moving keeps the elements; shapes still convert to and from std::vector
+    cout << "\n2. Moves and conversions:" << endl;
+    Tensor<double> moved = std::move(small);
+    vector<size_t> shape = moved.shape();
+    cout << "Moved: " << moved.view({4, 6}).shape().size() << "-D view of " << shape.size() << "-D tensor, "
+         << "same shape: " << (moved.shape() == shape) << noboolalpha << endl;
+}
+
 int main() {
     try {
         test_squeeze_unsqueeze();
         test_error_cases();
+        test_views();
+        test_slicing();
+        test_arithmetic();
+        test_indexing();
+        test_metadata();
     }
     catch (const exception& e) {
         cout << "Unexpected error: " << e.what() << endl;